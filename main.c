@@ -4,11 +4,23 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <sys/socket.h>
 
 // Include TryCatchC module header
 // #include <TryCatchC/trycatchc.h>
 // Here, use the local header file for dev/test purpose
 #include "trycatchc.h"
+#include "trycatchcsandbox.h"
+#include "trycatchcunit.h"
+#include "trycatchcpipeline.h"
+#include "trycatchcreactor.h"
+#include "trycatchcsupervisor.h"
+#include "trycatchcplugin.h"
 
 // Dummy function to test exception raised from a called function
 void fun() {
@@ -17,6 +29,190 @@ void fun() {
 
 }
 
+// Dummy function to test the sandbox, crash if the input is 0, else
+// double it
+void SandboxFun(
+   void* data,
+  size_t size) {
+
+  (void)size;
+  int* val = data;
+  if (*val == 0) {
+
+    int volatile* volatile p = NULL;
+    *p = 1;
+
+  }
+
+  *val *= 2;
+
+}
+
+// Dummy function to test the sandbox, return the PID of the helper
+// process running it
+void SandboxPid(
+   void* data,
+  size_t size) {
+
+  (void)size;
+  *(int*)data = (int)getpid();
+
+}
+
+// Dummy function to test TryEach, raise an exception if the element is
+// negative
+void EachFun(
+  void* elem) {
+
+  if (*(int*)elem < 0) Raise(TryCatchExc_OutOfRange);
+
+}
+
+// Dummy function to test TryCatchResult, fail if the argument is odd,
+// else return its half
+struct TryCatchResult ResultFun(
+  int const val) {
+
+  if (val % 2 != 0) TryCatchReturnFail(TryCatchExc_OutOfRange);
+  return TryCatchOkInt(val / 2);
+
+}
+
+// Dummy stages to test the pipeline, the first one rejects the negative
+// values, the second one doubles the values
+void* PipelineCheck(
+  void* item,
+  void* arg) {
+
+  (void)arg;
+  if (*(int*)item < 0) Raise(TryCatchExc_OutOfRange);
+  return item;
+
+}
+
+void* PipelineDouble(
+  void* item,
+  void* arg) {
+
+  (void)arg;
+  *(int*)item *= 2;
+  return item;
+
+}
+
+// Dummy callback to test the reactor, read one byte, raise an exception
+// for 'x' and leave a TryCatch block open for 'y'
+void ReactorOnEvt(
+  struct TryCatchReactorConn* conn,
+                     uint32_t events) {
+
+  (void)events;
+  char c = 0;
+  if (read(TryCatchReactorGetFd(conn), &c, 1) != 1) return;
+  if (c == 'x') Raise(TryCatchExc_IOError);
+  if (c == 'y') {
+
+    Try {
+
+      printf("Reactor leaves a TryCatch block open\n");
+      return;
+
+    } EndCatch;
+
+  }
+
+  printf("Reactor received %c\n", c);
+
+}
+
+// Dummy error callback to test the reactor
+void ReactorOnErr(
+  struct TryCatchReactorConn* conn,
+                          int exc,
+   struct TryCatchSite const* site) {
+
+  (void)conn;
+  printf(
+    "Reactor error callback for %s raised in %s, line %d\n",
+    TryCatchExcToStr(exc),
+    site->filename,
+    site->line);
+
+}
+
+// Dummy handler to test the resumable exceptions, replace NaN with 0
+bool ResumeNaN(
+                         int exc,
+                       void* value,
+  struct TryCatchSite const* site) {
+
+  (void)exc; (void)site;
+  *(double*)value = 0.0;
+  return true;
+
+}
+
+// Dummy function to test the resumable exceptions, sum the values and
+// replace the NaN values with the value supplied by a handler
+double ResumableSum(
+  double const* const vals,
+           int const nbVal) {
+
+  double sum = 0.0;
+  for (
+    int iVal = 0;
+    iVal < nbVal;
+    ++iVal) {
+
+    double val = vals[iVal];
+    if (isnan(val)) RaiseResumable(TryCatchExc_NaN, &val);
+    sum += val;
+
+  }
+
+  return sum;
+
+}
+
+// Dummy worker to test the supervisor, fail until it has been run three
+// times
+void SupervisorWorker(
+  void* arg) {
+
+  int* nbRun = arg;
+  ++(*nbRun);
+  if (*nbRun < 3) Raise(TryCatchExc_IOError);
+
+}
+
+// Dummy unit tests to test the runner: one passing, one failing an
+// assertion, one crashing and one never ending
+TryCatchTest(TestPass) {
+
+  TryCatchTestAssert(1 + 1 == 2);
+
+}
+
+TryCatchTest(TestAssert) {
+
+  TryCatchTestAssert(1 + 1 == 3);
+
+}
+
+TryCatchTest(TestSegv) {
+
+  int volatile* volatile p = NULL;
+  *p = 1;
+
+}
+
+TryCatchTest(TestTimeout) {
+
+  bool volatile isLooping = true;
+  while (isLooping);
+
+}
+
 // Example of user-defined exceptions
 enum UserDefinedExceptions {
 
@@ -72,6 +268,49 @@ char const* ConflictExcToStr(int exc) {
 
 }
 
+// The example of cancellation of a blocked thread relies on the signal
+// sent by TryCatchCancel which is POSIX only, guard against this.
+#if TryCatchPosix
+
+// Context of the thread of the example of cancellation of a blocked
+// thread, published once the thread is running
+static struct TryCatchCtx* _Atomic sleeperCtx = NULL;
+
+// Thread of the example of cancellation of a blocked thread, sleeping
+// until it's cancelled
+// Input:
+//   arg: Unused
+// Output:
+//   Return 0
+int CancelSleeper(
+  void* arg) {
+
+  (void)arg;
+  Try {
+
+    atomic_store(
+      &sleeperCtx,
+      TryCatchGetCtx());
+    while (true) {
+
+      TryCatchCheckpoint();
+      thrd_sleep(
+        &(struct timespec){.tv_sec = 10},
+        NULL);
+
+    }
+
+  } Catch (TryCatchExc_Cancelled) {
+
+    printf("Caught exception Cancelled in the sleeping thread\n");
+
+  } EndCatch;
+  return 0;
+
+}
+
+#endif
+
 // Main function
 int main() {
 
@@ -93,7 +332,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 86.
+  // Exception (TryCatchException_NaN) raised in main.c, line 325.
   // Caught exception NaN
   //
 
@@ -117,7 +356,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 108.
+  // Exception (TryCatchException_NaN) raised in main.c, line 347.
   //
 
   // --------------
@@ -132,7 +371,7 @@ int main() {
 
   // Output:
   //
-  // Exception (User-defined exception (11)) raised in main.c, line 129.
+  // Exception (User-defined exception (14)) raised in main.c, line 368.
   //
 
   // --------------
@@ -149,7 +388,7 @@ int main() {
 
   // Output:
   //
-  // Exception (myUserExceptionA) raised in main.c, line 146.
+  // Exception (myUserExceptionA) raised in main.c, line 385.
   //
 
   // --------------
@@ -164,7 +403,7 @@ int main() {
 
   // Output:
   //
-  // Exception (myUserExceptionA) raised in main.c, line 161.
+  // Exception (myUserExceptionA) raised in main.c, line 400.
   // !!! TryCatch: Exception ID conflict, between conflicting exception
   // and myUserExceptionA !!!
   //
@@ -182,7 +421,7 @@ int main() {
 
   // Output:
   //
-  // Exception (conflicting exception) raised in main.c, line 179.
+  // Exception (conflicting exception) raised in main.c, line 418.
   // !!! TryCatch: Exception ID conflict, between conflicting exception
   // and myUserExceptionA !!!
   //
@@ -210,7 +449,7 @@ int main() {
 
   // Output:
   //
-  // Exception (conflicting exception) raised in main.c, line 195.
+  // Exception (conflicting exception) raised in main.c, line 434.
   // Caught user-defined exception A
   //
 
@@ -230,7 +469,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 16.
+  // Exception (TryCatchException_NaN) raised in main.c, line 28.
   // Caught exception NaN raised in called function
   //
 
@@ -246,7 +485,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 16.
+  // Exception (TryCatchException_NaN) raised in main.c, line 28.
   //
 
   // --------------
@@ -256,7 +495,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 255.
+  // Exception (TryCatchException_NaN) raised in main.c, line 494.
   //
 
   // --------------
@@ -279,7 +518,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 267.
+  // Exception (TryCatchException_NaN) raised in main.c, line 506.
   // Caught exception TryCatchException_NaN
   //
 
@@ -301,7 +540,7 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchException_NaN) raised in main.c, line 291.
+  // Exception (TryCatchException_NaN) raised in main.c, line 530.
   // Caught exception TryCatchException_NaN with CatchDefault
   //
 
@@ -334,8 +573,8 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchExc_IOError) raised in main.c, line 317.
-  // Exception (TryCatchExc_IOError) raised in main.c, line 325.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 556.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 564.
   // Caught manually delayed exception TryCatchExc_IOError.
   //
 
@@ -360,8 +599,8 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchExc_IOError) raised in main.c, line 347.
-  // Exception (TryCatchExc_MallocFailed) raised in main.c, line 357.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 586.
+  // Exception (TryCatchExc_MallocFailed) raised in main.c, line 596.
   // Caught exception from user default catch block TryCatchExc_MallocFailed.
   //
 
@@ -391,14 +630,14 @@ int main() {
 
   // Output:
   //
-  // Exception (TryCatchExc_IOError) raised in main.c, line 375.
-  // Exception (TryCatchExc_MallocFailed) raised in main.c, line 379.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 614.
+  // Exception (TryCatchExc_MallocFailed) raised in main.c, line 618.
   // Caught exception raised from catch block TryCatchExc_MallocFailed.
   //
 
-// The struct siginfo_t used to handle the SIGSEV is not defined in
-// ANSI C, guard against this.
-#ifndef __STRICT_ANSI__
+// The struct siginfo_t used to handle the SIGSEV is POSIX only, guard
+// against this.
+#if TryCatchPosix
 
   // --------------
   // Example of handling exception raised by SIGSEV and ReCatch-ing to
@@ -420,10 +659,36 @@ int main() {
 
   // Output:
   //
-  //  Exception (TryCatchExc_Segv) raised in main.c, line 414.
-  //  Exception (TryCatchExc_Segv) raised in main.c, line 414.
+  // Exception (TryCatchExc_Segv) raised in main.c, line 652.
   // Caught exception Segv
   //
+
+  // --------------
+  // Example of probing memory which may be invalid
+
+  // Init the SIGBUS signal handling by TryCatch, raised by the probes of
+  // truncated mapped files (SIGSEV has been set above)
+  TryCatchInitHandlerSigBus();
+
+  char probeBuf[8];
+  Try {
+
+    TryCatchProbeRead(
+      probeBuf,
+      (void*)16,
+      sizeof(probeBuf));
+
+  } Catch (TryCatchExc_Segv) {
+
+    printf("Caught exception Segv while probing\n");
+
+  } EndCatch;
+
+  // Output:
+  //
+  // Exception (TryCatchExc_Segv) raised in main.c, line 676.
+  // Caught exception Segv while probing
+  //
 #endif
 
   // --------------
@@ -470,7 +735,7 @@ int main() {
 
   // Output (order varies depending on thread execution):
   //
-  //  Exception (TryCatchException_NaN) raised in main.c, line 442.
+  //  Exception (TryCatchException_NaN) raised in main.c, line 707.
   //  Caught exception NaN in thread 1
   //  thread 2 ok
 
@@ -496,9 +761,826 @@ int main() {
   } EndCatch;
 
   // Output:
-  // Exception (TryCatchExc_IOError) raised in main.c, line 484.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 749.
   // Caught forward exception TryCatchExc_IOError
 
+  // --------------
+  // Example of TryCatch block catching only a given list of exceptions,
+  // other exceptions skip it and jump directly to the enclosing block.
+
+  Try {
+
+    TryFor (TryCatchExc_MallocFailed, TryCatchExc_NaN) {
+
+      Raise(TryCatchExc_IOError);
+
+    } Catch (TryCatchExc_MallocFailed)
+      CatchAlso (TryCatchExc_NaN) {
+
+      printf("Not reached\n");
+
+    } EndCatch;
+
+    printf("Not reached either\n");
+
+  } Catch (TryCatchExc_IOError) {
+
+    printf("Caught exception IOError skipping the inner block\n");
+
+  } EndCatch;
+
+  // Output:
+  // Exception (TryCatchExc_IOError) raised in main.c, line 775.
+  // Caught exception IOError skipping the inner block
+
+  // --------------
+  // Example of sandbox running a function susceptible of crashing in a
+  // helper process.
+
+  struct TryCatchSandbox* sandbox =
+    TryCatchSandboxCreate(
+      1,
+      sizeof(int));
+
+  int pidBefore = 0;
+  int pidAfter = 0;
+  TryCatchSandboxRun(
+    sandbox,
+    SandboxPid,
+    NULL,
+    0,
+    &pidBefore,
+    sizeof(int));
+  Try {
+
+    int val = 0;
+    TryCatchSandboxRun(
+      sandbox,
+      SandboxFun,
+      &val,
+      sizeof(int),
+      &val,
+      sizeof(int));
+
+  } Catch (TryCatchExc_Segv) {
+
+    printf("Caught exception Segv from the sandbox\n");
+
+  } EndCatch;
+
+  Try {
+
+    int val = 21;
+    TryCatchSandboxRun(
+      sandbox,
+      SandboxFun,
+      &val,
+      sizeof(int),
+      &val,
+      sizeof(int));
+    printf("Sandbox result %d\n", val);
+
+  } EndCatch;
+
+  TryCatchSandboxRun(
+    sandbox,
+    SandboxPid,
+    NULL,
+    0,
+    &pidAfter,
+    sizeof(int));
+  printf(
+    "Crashed helper process replaced: %s\n",
+    (pidBefore != pidAfter ? "yes" : "no"));
+  TryCatchSandboxFree(&sandbox);
+
+  // Output:
+  //
+  // Exception (TryCatchExc_Segv) raised in main.c, line 817.
+  // Caught exception Segv from the sandbox
+  // Sandbox result 42
+  // Crashed helper process replaced: yes
+  //
+
+  // --------------
+  // Example of TryCatch block using an explicit context, which avoids the
+  // lookup of the thread local context on each operation.
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+
+  TryCtx(ctx) {
+
+    RaiseCtx(ctx, TryCatchExc_NaN);
+
+  } CatchCtx(ctx, TryCatchExc_NaN) {
+
+    printf("Caught exception NaN with an explicit context\n");
+
+  } EndCatchCtx(ctx);
+
+  // Output:
+  // Exception (TryCatchException_NaN) raised in main.c, line 873.
+  // Caught exception NaN with an explicit context
+
+  // --------------
+  // Example of TryCatch block attempted again with a backoff delay when
+  // a transient exception is raised.
+
+  static struct TryCatchRetryPolicy retryPolicy = {
+    .delay = 1000000, .factor = 2.0, .maxDelay = 10000000, .jitter = 1.0};
+  static int nbCall = 0;
+
+  TryRetry (5, &retryPolicy, TryCatchExc_IOError) {
+
+    ++nbCall;
+    if (nbCall < 3) Raise(TryCatchExc_IOError);
+    printf("Succeeded at attempt %d\n", nbCall);
+
+  } Catch (TryCatchExc_IOError) {
+
+    printf("Failed after all attempts\n");
+
+  } EndCatch;
+
+  TryRetry (2, &retryPolicy, TryCatchExc_IOError) {
+
+    Raise(TryCatchExc_IOError);
+
+  } Catch (TryCatchExc_IOError) {
+
+    printf("Failed after all attempts\n");
+
+  } EndCatch;
+
+  struct TryCatchRetryStats retryStats =
+    TryCatchGetRetryStats(&retryPolicy);
+  printf(
+    "%lu blocks, %lu attempts, %lu failures\n",
+    (unsigned long)retryStats.nbBlock,
+    (unsigned long)retryStats.nbAttempt,
+    (unsigned long)retryStats.nbFailure);
+
+  // Output:
+  // Exception (TryCatchExc_IOError) raised in main.c, line 896.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 896.
+  // Succeeded at attempt 3
+  // Exception (TryCatchExc_IOError) raised in main.c, line 907.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 907.
+  // Failed after all attempts
+  // 2 blocks, 5 attempts, 1 failures
+
+  // --------------
+  // Example of TryCatch block protected by a circuit breaker, skipped
+  // after it has failed too often.
+
+  static struct TryCatchBreaker breaker = {
+    .window = 2, .threshold = 0.5, .openDelay = 1000000000};
+
+  for (
+    volatile int iCall = 0;
+    iCall < 3;
+    ++iCall) {
+
+    TryBreaker (&breaker) {
+
+      Raise(TryCatchExc_IOError);
+
+    } Catch (TryCatchExc_IOError) {
+
+      printf("Caught exception IOError in the protected block\n");
+
+    } Catch (TryCatchExc_CircuitOpen) {
+
+      printf("Skipped the protected block, the circuit is open\n");
+
+    } EndCatch;
+
+  }
+
+  // Output:
+  // Exception (TryCatchExc_IOError) raised in main.c, line 946.
+  // Caught exception IOError in the protected block
+  // Exception (TryCatchExc_IOError) raised in main.c, line 946.
+  // Caught exception IOError in the protected block
+  // Exception (TryCatchExc_CircuitOpen) raised in main.c, line 944.
+  // Skipped the protected block, the circuit is open
+
+  // --------------
+  // Example of fault injection, raising an exception every second time
+  // an injection point of main.c is reached. The rules can also be given
+  // in the environment variable TRYCATCH_INJECT with
+  // TryCatchInitInjection().
+
+  TryCatchAddInjectionRules("main.c TryCatchExc_IOError every=2");
+
+  for (
+    volatile int iCall = 0;
+    iCall < 4;
+    ++iCall) {
+
+    Try {
+
+      TryCatchInjectionPoint();
+      printf("Passed the injection point\n");
+
+    } Catch (TryCatchExc_IOError) {
+
+      printf("Caught exception IOError from the injection point\n");
+
+    } EndCatch;
+
+  }
+
+  TryCatchClearInjection();
+
+  // Output:
+  // Passed the injection point
+  // Exception (TryCatchExc_IOError) raised in main.c, line 983.
+  // Caught exception IOError from the injection point
+  // Passed the injection point
+  // Exception (TryCatchExc_IOError) raised in main.c, line 983.
+  // Caught exception IOError from the injection point
+
+  // --------------
+  // Example of context of a fiber, attached to the thread while the fiber
+  // is running and detached when it's suspended, in place of the context
+  // of the thread.
+
+  struct TryCatchCtx* fiberCtx = TryCatchCtxCreate(8);
+  struct TryCatchCtx* threadCtx = TryCatchCtxAttach(fiberCtx);
+
+  Try {
+
+    Raise(TryCatchExc_NaN);
+
+  } Catch (TryCatchExc_NaN) {
+
+    printf("Caught exception NaN in the context of the fiber\n");
+
+  } EndCatch;
+
+  TryCatchCtxAttach(threadCtx);
+  TryCatchCtxFree(&fiberCtx);
+
+  // Output:
+  // Exception (TryCatchException_NaN) raised in main.c, line 1014.
+  // Caught exception NaN in the context of the fiber
+
+  // --------------
+  // Example of function applied to each element of an array, isolating
+  // the failing elements.
+
+  int elems[5] = {1, -2, 3, -4, 5};
+  struct TryCatchEachFailure* failures = NULL;
+  size_t nbFailure = 0;
+  TryEach(
+    elems,
+    5,
+    EachFun,
+    &failures,
+    nbFailure);
+  for (
+    size_t iFailure = 0;
+    iFailure < nbFailure;
+    ++iFailure) {
+
+    printf(
+      "Element %zu failed with exception %s\n",
+      failures[iFailure].index,
+      TryCatchExcToStr(failures[iFailure].exc));
+
+  }
+
+  free(failures);
+
+  // Output:
+  // Exception (TryCatchExc_OutOfRange) raised in main.c, line 67.
+  // Exception (TryCatchExc_OutOfRange) raised in main.c, line 67.
+  // Element 1 failed with exception TryCatchExc_OutOfRange
+  // Element 3 failed with exception TryCatchExc_OutOfRange
+
+  // --------------
+  // Example of transaction, rolling back the logged writes when an
+  // exception is raised.
+
+  static int account[2] = {100, 0};
+
+  TryTransaction {
+
+    TryCatchLogWrite(account, sizeof(account));
+    account[0] -= 50;
+    account[1] += 50;
+    Raise(TryCatchExc_IOError);
+
+  } Catch (TryCatchExc_IOError) {
+
+    printf(
+      "Transfer rolled back, accounts are %d and %d\n",
+      account[0],
+      account[1]);
+
+  } EndCatch;
+
+  // Output:
+  // Exception (TryCatchExc_IOError) raised in main.c, line 1073.
+  // Transfer rolled back, accounts are 100 and 0
+
+  // --------------
+  // Example of result returned instead of raising an exception, checked
+  // inline or escalated to an exception.
+
+  struct TryCatchResult res = ResultFun(3);
+  if (TryCatchIsOk(res) == false)
+    printf(
+      "Result failed with exception %s\n",
+      TryCatchExcToStr(res.exc));
+
+  Try {
+
+    printf(
+      "Unwrapped result %d\n",
+      (int)TryCatchUnwrap(ResultFun(4)).i);
+    TryCatchUnwrap(ResultFun(5));
+
+  } Catch (TryCatchExc_OutOfRange) {
+
+    printf("Caught exception OutOfRange from the unwrapped result\n");
+
+  } EndCatch;
+
+  // Output:
+  // Result failed with exception TryCatchExc_OutOfRange
+  // Unwrapped result 2
+  // Exception (TryCatchExc_OutOfRange) raised in main.c, line 76.
+  // Caught exception OutOfRange from the unwrapped result
+
+  // --------------
+  // Example of cancellation, requested here by the thread itself but
+  // usually by another thread with the context of the cancelled thread.
+
+  TryCatchCancel(TryCatchGetCtx());
+
+  Try {
+
+    for (
+      int iStep = 0;
+      iStep < 10;
+      ++iStep) {
+
+      TryCatchCheckpoint();
+      printf("Step %d\n", iStep);
+
+    }
+
+  } Catch (TryCatchExc_Cancelled) {
+
+    printf("Caught exception Cancelled at the checkpoint\n");
+
+  } EndCatch;
+
+  // Output:
+  // Exception (TryCatchExc_Cancelled) raised in main.c, line 1130.
+  // Caught exception Cancelled at the checkpoint
+
+// The signal sent by TryCatchCancel is POSIX only, guard against this.
+#if TryCatchPosix
+
+  // --------------
+  // Example of cancellation of a thread blocked in a system call. The
+  // signal sent by TryCatchCancel interrupts its sleep, which would last
+  // 10s else, and the thread reaches its checkpoint without delay.
+
+  TryCatchInitCancelSignal(SIGUSR2);
+  thrd_t sleeper;
+  if (
+    thrd_create(
+      &sleeper,
+      CancelSleeper,
+      NULL) == thrd_success) {
+
+    // Wait for the thread to run, and let it fall asleep
+    while (atomic_load(&sleeperCtx) == NULL) thrd_yield();
+    thrd_sleep(
+      &(struct timespec){.tv_nsec = 100000000},
+      NULL);
+    TryCatchCancel(atomic_load(&sleeperCtx));
+    thrd_join(
+      sleeper,
+      NULL);
+
+  }
+
+  TryCatchInitCancelSignal(0);
+
+  // Output:
+  // Exception (TryCatchExc_Cancelled) raised in main.c, line 296.
+  // Caught exception Cancelled in the sleeping thread
+#endif
+
+  // --------------
+  // Example of unit tests, run in parallel by 2 threads with a timeout of
+  // 0.1s per test. The tests are defined at the top of this file.
+
+  int nbFailedTest =
+    TryCatchTestRun(
+      2,
+      0.1,
+      NULL);
+  printf("%d failed test(s)\n", nbFailedTest);
+
+  // Output (the order of the raises and the times may vary):
+  // Exception (TryCatchExc_UnitTestFailed) raised in main.c, line 198.
+  // [PASS] TestPass (0.000s)
+  // [FAIL] TestAssert (0.000s): exception (TryCatchExc_UnitTestFailed) raised in main.c, line 198.
+  // [FAIL] TestSegv (0.000s): exception (TryCatchExc_Segv) in test defined in main.c, line 202.
+  // [FAIL] TestTimeout (0.100s): exception (TryCatchExc_InfiniteLoop) in test defined in main.c, line 209.
+  // 4 test(s), 3 failed
+  // 3 failed test(s)
+
+  // --------------
+  // Example of latency histograms, sampling all the TryTimed blocks
+
+  TryCatchSetLatencySampling(1);
+  for (
+    volatile int iCall = 0;
+    iCall < 4;
+    ++iCall) {
+
+    TryTimed {
+
+      if (iCall == 0) Raise(TryCatchExc_IOError);
+
+    } CatchDefault {
+
+      printf("Caught exception IOError in the timed block\n");
+
+    } EndCatch;
+
+  }
+
+  TryCatchDumpLatency(stdout);
+  TryCatchSetLatencySampling(0);
+
+  // Output (the times vary):
+  // Exception (TryCatchExc_IOError) raised in main.c, line 1211.
+  // Caught exception IOError in the timed block
+  // main.c, line 1209 (block): 4 samples, mean 14561ns, p50 59ns, p99 61439ns, p999 61439ns
+  // main.c, line 1209 (unwind): 1 samples, mean 948ns, p50 959ns, p99 959ns, p999 959ns
+
+  // --------------
+  // Example of pipeline, the items failing in a stage are routed to the
+  // dead-letter queue and the others keep flowing
+
+  TryCatchPipelineFun pipelineFuns[] = {PipelineCheck, PipelineDouble};
+  struct TryCatchPipeline* pipeline =
+    TryCatchPipelineCreate(
+      2,
+      pipelineFuns,
+      NULL,
+      16);
+  int pipelineItems[] = {1, 2, -3, 4};
+  for (
+    int iItem = 0;
+    iItem < 4;
+    ++iItem) {
+
+    TryCatchPipelinePush(
+      pipeline,
+      pipelineItems + iItem);
+
+  }
+
+  TryCatchPipelineClose(pipeline);
+  int nbOut = 0;
+  int outs[4];
+  int nbDead = 0;
+  struct TryCatchDeadLetter deads[4];
+  while (TryCatchPipelineIsDone(pipeline) == false) {
+
+    void* item = NULL;
+    if (
+      TryCatchPipelinePop(
+        pipeline,
+        &item)) {
+
+      outs[nbOut++] = *(int*)item;
+
+    } else if (
+      TryCatchPipelinePopDeadLetter(
+        pipeline,
+        deads + nbDead)) {
+
+      ++nbDead;
+
+    }
+
+  }
+
+  for (
+    int iItem = 0;
+    iItem < nbOut;
+    ++iItem) {
+
+    printf("Pipeline output %d\n", outs[iItem]);
+
+  }
+
+  for (
+    int iItem = 0;
+    iItem < nbDead;
+    ++iItem) {
+
+    printf(
+      "Dead letter %d from stage %d, exception %s raised in %s, line %d\n",
+      *(int*)(deads[iItem].item),
+      deads[iItem].stage,
+      TryCatchExcToStr(deads[iItem].exc),
+      deads[iItem].site->filename,
+      deads[iItem].site->line);
+
+  }
+
+  printf(
+    "Stage 0 processed %" PRIu64 " items, failed %" PRIu64 " items\n",
+    TryCatchPipelineGetStats(pipeline, 0).nbProcessed,
+    TryCatchPipelineGetStats(pipeline, 0).nbFailed);
+  TryCatchPipelineFree(&pipeline);
+
+  // Output:
+  // Exception (TryCatchExc_OutOfRange) raised in main.c, line 88.
+  // Pipeline output 2
+  // Pipeline output 4
+  // Pipeline output 8
+  // Dead letter -3 from stage 0, exception TryCatchExc_OutOfRange raised in main.c, line 88
+  // Stage 0 processed 3 items, failed 1 items
+
+  // --------------
+  // Example of reactor, with a socketpair. The exception raised by the
+  // callback goes to the error callback, the TryCatch block left open by
+  // the callback is ended after the dispatch and the loop goes on.
+
+  int reactorFds[2];
+  if (
+    socketpair(
+      AF_UNIX,
+      SOCK_STREAM,
+      0,
+      reactorFds) == 0) {
+
+    struct TryCatchReactor* reactor = TryCatchReactorCreate();
+    struct TryCatchReactorConn* conn =
+      TryCatchReactorAdd(
+        reactor,
+        reactorFds[0],
+        EPOLLIN,
+        ReactorOnEvt,
+        ReactorOnErr,
+        NULL);
+    if (write(reactorFds[1], "axyb", 4) == 4)
+      while (TryCatchReactorRun(reactor, 0) > 0);
+    printf(
+      "Reactor level %d, %" PRIu64 " exception(s) on the connection\n",
+      TryCatchGetLevel(),
+      TryCatchReactorGetNbExc(conn));
+    TryCatchReactorFree(&reactor);
+    close(reactorFds[0]);
+    close(reactorFds[1]);
+
+  }
+
+  // Output:
+  // Reactor received a
+  // Exception (TryCatchExc_IOError) raised in main.c, line 112.
+  // Reactor error callback for TryCatchExc_IOError raised in main.c, line 112
+  // Reactor leaves a TryCatch block open
+  // Reactor received b
+  // Reactor level 0, 1 exception(s) on the connection
+
+  // --------------
+  // Example of supervisor, the first worker fails twice and is restarted
+  // in its thread until it returns, the second one returns at once.
+
+  int supervisorNbRun[2] = {0, 2};
+  TryCatchSupervisorFun supervisorFuns[2] = {
+    SupervisorWorker,
+    SupervisorWorker
+  };
+  void* supervisorArgs[2] = {
+    supervisorNbRun,
+    supervisorNbRun + 1
+  };
+  struct TryCatchSupervisor* supervisor =
+    TryCatchSupervisorCreate(
+      2,
+      supervisorFuns,
+      supervisorArgs,
+      TryCatchSupervisorStrategy_OneForOne,
+      5,
+      1.0);
+  if (supervisor != NULL) {
+
+    bool isSupervisorOk = TryCatchSupervisorRun(supervisor);
+    printf(
+      "Supervisor %s, worker 0 restarted %" PRIu64 " times\n",
+      (isSupervisorOk ? "ok" : "failed"),
+      TryCatchSupervisorGetNbRestart(
+        supervisor,
+        0));
+    TryCatchSupervisorFree(&supervisor);
+
+  }
+
+  // Output:
+  // Exception (TryCatchExc_IOError) raised in main.c, line 184.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 184.
+  // Supervisor ok, worker 0 restarted 2 times
+
+  // --------------
+  // Example of plugin host, the plugin raises its own exception for the
+  // negative arguments and a segmentation fault for the null ones (caught
+  // as TryCatchInitHandlerSigSegv() has been called). It is quarantined
+  // after two faults, then reloaded which resets its state.
+
+  struct TryCatchPluginHost* pluginHost =
+    TryCatchPluginHostCreate(
+      1000,
+      2);
+  struct TryCatchPlugin* plugin =
+    TryCatchPluginLoad(
+      pluginHost,
+      "./mainplugin.so",
+      "MainPluginRun");
+  if (plugin != NULL) {
+
+    int pluginArgs[5] = {1, -1, 0, 1, 1};
+    for (
+      int iCall = 0;
+      iCall < 5;
+      ++iCall) {
+
+      if (iCall == 4) {
+
+        bool isQuarantined = TryCatchPluginIsQuarantined(plugin);
+        printf(
+          "Plugin quarantined %d, %d plugin(s) reloaded\n",
+          isQuarantined,
+          TryCatchPluginHostReload(pluginHost));
+
+      }
+
+      int exc =
+        TryCatchPluginCall(
+          plugin,
+          pluginArgs + iCall);
+      if (exc != 0)
+        printf(
+          "Plugin call failed with %s, owned by the plugin %d\n",
+          TryCatchExcToStr(exc),
+          TryCatchPluginGetExcOwner(pluginHost, exc) == plugin);
+
+    }
+
+    struct TryCatchPluginStats pluginStats = TryCatchPluginGetStats(plugin);
+    printf(
+      "Plugin %" PRIu64 " calls, %" PRIu64 " exceptions, %" PRIu64
+      " rejected, %" PRIu64 " reload\n",
+      pluginStats.nbCall,
+      pluginStats.nbExc,
+      pluginStats.nbRejected,
+      pluginStats.nbReload);
+
+  }
+
+  TryCatchPluginHostFree(&pluginHost);
+
+  // Output:
+  // Plugin call 1 since loading
+  // Exception (User-defined exception (1000)) raised in mainplugin.c, line 36.
+  // Plugin call failed with User-defined exception (1000), owned by the plugin 1
+  // Plugin call failed with TryCatchExc_Segv, owned by the plugin 0
+  // Plugin call failed with TryCatchExc_CircuitOpen, owned by the plugin 0
+  // Plugin quarantined 1, 1 plugin(s) reloaded
+  // Plugin call 1 since loading
+  // Plugin 4 calls, 2 exceptions, 1 rejected, 1 reload
+
+  // --------------
+  // Example of resumable exception, the NaN values are replaced by the
+  // handler and the sum goes on without unwinding. Without handler the
+  // exception is raised as usual.
+
+  double resumableVals[] = {1.0, NAN, 2.0};
+  TryCatchAddResumeFun(
+    TryCatchExc_NaN,
+    ResumeNaN);
+  printf(
+    "Resumable sum %.1f\n",
+    ResumableSum(
+      resumableVals,
+      3));
+  TryCatchRemoveResumeFun(
+    TryCatchExc_NaN,
+    ResumeNaN);
+  Try {
+
+    ResumableSum(
+      resumableVals,
+      3);
+
+  } Catch (TryCatchExc_NaN) {
+
+    printf("Caught exception NaN without resume handler\n");
+
+  } EndCatch;
+
+  // Output:
+  // Resumable sum 3.0
+  // Exception (TryCatchException_NaN) raised in main.c, line 168.
+  // Caught exception NaN without resume handler
+
+  // --------------
+  // Example of binary trace file, recording the raises in a memory-mapped
+  // file which is then decoded by the tool trycatchcdecode.
+
+#if TryCatchPosix
+  if (
+    TryCatchSetRaiseTraceFile(
+      "main.trace",
+      4096)) {
+
+    for (
+      volatile int iRaise = 0;
+      iRaise < 2;
+      ++iRaise) {
+
+      Try {
+
+        Raise(TryCatchExc_IOError);
+
+      } CatchDefault {
+
+      } EndCatch;
+
+    }
+
+    Try {
+
+      Raise(TryCatchExc_NaN);
+
+    } CatchDefault {
+
+    } EndCatch;
+
+    TryCatchSetRaiseTraceFile(
+      NULL,
+      0);
+    fflush(stdout);
+    if (system("./trycatchcdecode -top 10 main.trace") != 0)
+      printf("Couldn't decode the trace file\n");
+    remove("main.trace");
+
+  }
+#endif
+
+  // Output:
+  // Exception (TryCatchExc_IOError) raised in main.c, line 1517.
+  // Exception (TryCatchExc_IOError) raised in main.c, line 1517.
+  // Exception (TryCatchException_NaN) raised in main.c, line 1527.
+  // main.c, line 1517: 2 raises
+  // main.c, line 1527: 1 raises
+
+  // --------------
+  // Example of flight recorder, dumping the last events of the thread
+  // when an exception is raised outside of any TryCatch block.
+
+  TryCatchInitFlightRecorder();
+
+  Try {
+
+    Raise(TryCatchExc_NaN);
+
+  } CatchDefault {
+
+    printf("Caught exception with the flight recorder on\n");
+
+  } EndCatch;
+
+  Raise(TryCatchExc_IOError);
+
+  // Output (on stderr for the flight recorder):
+  // Exception (TryCatchException_NaN) raised in main.c, line 1559.
+  // Caught exception with the flight recorder on
+  // Exception (TryCatchExc_IOError) raised in main.c, line 1567.
+  // !!! TryCatch: exception raised outside of any TryCatch block !!!
+  // --- TryCatch flight recorder, thread 1 ---
+  // ...
+  // 1792353956.431606982 level 1 enter
+  // 1792353956.431609113 level 1 raise exception (TryCatchException_NaN)
+  //   in main.c, line 1559
+  // 1792353956.431610072 level 1 catch exception (TryCatchException_NaN)
+  // 1792353956.431610158 level 0 exit
+  // 1792353956.431610239 level 0 raise exception (TryCatchExc_IOError)
+  //   in main.c, line 1567
+
   // --------------
   // Example of overflow of recursive inclusion of TryCatch blocks.
 
@@ -0,0 +1,48 @@
+// ------------------ mainplugin.c ------------------
+
+// Dummy plugin to test the plugin host in main.c
+
+// Include external modules header
+#include <stdio.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// First exception ID of the range of the plugin
+static int excBase = 0;
+
+// Number of calls since the plugin has been loaded
+static int nbCall = 0;
+
+// Initialisation function of the plugin, called by the host at loading
+// Input:
+//   base: The first exception ID of the range of the plugin
+void TryCatchPluginInit(
+  int const base) {
+
+  excBase = base;
+
+}
+
+// Entry point of the plugin, raise the first exception of its range if
+// the argument is negative, write through a null pointer if it's null,
+// else print the number of calls since loading
+// Input:
+//   arg: The argument
+void MainPluginRun(
+  void* arg) {
+
+  ++nbCall;
+  if (*(int*)arg < 0) Raise(excBase);
+  if (*(int*)arg == 0) {
+
+    int volatile* volatile ptr = NULL;
+    *ptr = 1;
+
+  }
+
+  printf("Plugin call %d since loading\n", nbCall);
+
+}
+
+// ------------------ mainplugin.c ------------------
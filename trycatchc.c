@@ -1,7 +1,26 @@
 // ------------------ trycatchc.c ------------------
 
+// The features relying on POSIX are built whatever the C standard used for
+// compilation (cf. TryCatchPosix), request their declaration
+#define _GNU_SOURCE
+
 // Include the header
 #include "trycatchc.h"
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+#include <limits.h>
+#include <inttypes.h>
+
+// The binary trace file is based on mmap which is POSIX only, guard
+// against this.
+#if TryCatchPosix
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 // Size of the stack of TryCatch blocks, define how many recursive incursion
 // of TryCatch blocks can be done, overflow is checked at the beginning of
@@ -12,26 +31,176 @@
 #define TryCatchMaxExcLvl 256
 #endif
 
-// Stack of jmp_buf to memorise the TryCatch blocks
-// To avoid exposing this variable to the user, implement any code using
-// it as functions here instead of in the #define-s of trycatch.h
-static _Thread_local jmp_buf tryCatchExcJmp[TryCatchMaxExcLvl];
+// Frame of a TryCatch block in the stack of a context
+struct TryCatchFrame {
 
-// Index of the next TryCatch block in the stack of jmp_buf
-// To avoid exposing this variable to the user, implement any code using
-// it as functions here instead of in the #define-s of trycatch.h
-static _Thread_local int tryCatchExcLvl = 0;
+  // jmp_buf to jump back to the block
+  jmp_buf jmp;
+
+  // List of exceptions caught by the block (terminated by 0), NULL if the
+  // block catches all exceptions
+  int const* filter;
+
+  // Flag to memorise if we are inside a catch block of the block
+  bool inCatch;
+
+  // Maximum number of attempts of the block, 0 if the block is not a
+  // TryRetry block or if it has ended
+  int retryMax;
+
+  // Number of attempts of the block so far
+  int retryAttempt;
+
+  // Backoff policy of the block (can be NULL)
+  struct TryCatchRetryPolicy* retryPolicy;
+
+  // Time of the beginning of the first attempt, in nanoseconds
+  uint64_t retryStart;
+
+  // Circuit breaker of the block, NULL if the block is not a TryBreaker
+  // block or if its outcome has been recorded
+  struct TryCatchBreaker* breaker;
+
+  // Flag to memorise if the block is the probe of a half-open circuit
+  bool isProbe;
+
+  // Flag to memorise if the block is a TryTransaction block
+  bool isTransaction;
+
+  // Size of the undo log at the entrance of the block
+  size_t undoMark;
+
+  // Site of the block if it's a sampled TryTimed block, else NULL
+  struct TryCatchSite* timedSite;
 
-// ID of the last raised exception
-// To avoid exposing this variable to the user, implement any code using
+  // Time of the entrance in the block, in nanoseconds
+  uint64_t timedStart;
+
+  // Time of the raise of the exception being unwound to the block, in
+  // nanoseconds, 0 if none
+  uint64_t unwindStart;
+
+};
+
+// Max number of handlers of resumable exceptions per context
+#ifndef TryCatchMaxNbResumeFun
+#define TryCatchMaxNbResumeFun 64
+#endif
+
+// Handler of a resumable exception
+struct TryCatchResumeHandler {
+
+  // Handled exception
+  int exc;
+
+  // Handling function
+  TryCatchResumeFun fun;
+
+};
+
+// Context of execution of TryCatch blocks
+// To avoid exposing this structure to the user, implement any code using
 // it as functions here instead of in the #define-s of trycatch.h
-// Do not use the type enum TryCatchException to allow the user to extend
-// the list of exceptions with user-defined exceptions outside of enum
-// TryCatchException.
-static _Thread_local int tryCatchExc = 0;
+struct TryCatchCtx {
+
+  // Stack of frames to memorise the TryCatch blocks
+  struct TryCatchFrame* frames;
+
+  // Size of the stack of frames
+  int maxLvl;
+
+  // Index of the next TryCatch block in the stack of frames
+  int lvl;
+
+  // ID of the last raised exception
+  // Do not use the type enum TryCatchException to allow the user to extend
+  // the list of exceptions with user-defined exceptions outside of enum
+  // TryCatchException.
+  int exc;
+
+  // Site of the last raised exception (NULL if unknown), and the number
+  // of calls to TryCatchForgetSites when it has been raised
+  struct TryCatchSite const* site;
+  unsigned int siteGen;
 
-// Flag to memorise if we are inside a catch block at a given exception level
-static _Thread_local bool flagInCatchBlock[TryCatchMaxExcLvl] = {false};
+  // List of exceptions caught by the next TryCatch block
+  int const* nextFilter;
+
+  // Maximum number of attempts and backoff policy of the next TryCatch
+  // block if it's a TryRetry block
+  int nextRetryMax;
+  struct TryCatchRetryPolicy* nextRetryPolicy;
+
+  // Circuit breaker of the next TryCatch block if it's a TryBreaker block
+  struct TryCatchBreaker* nextBreaker;
+
+  // Flag to memorise if the next TryCatch block is a TryTransaction block
+  bool nextIsTransaction;
+
+  // Site of the next TryCatch block if it's a sampled TryTimed block
+  struct TryCatchSite* nextTimedSite;
+
+  // Number of running TryTransaction blocks
+  int nbTransaction;
+
+  // Undo log of the TryTransaction blocks: for each logged write, the
+  // previous bytes (padded to a multiple of 8 bytes) followed by a
+  // TryCatchUndoEntry
+  unsigned char* undo;
+
+  // Size of the undo log and of its buffer, in bytes
+  size_t undoSize;
+  size_t undoCapacity;
+
+  // Handlers of resumable exceptions, in their order of addition
+  // (allocated at the first addition, TryCatchMaxNbResumeFun handlers),
+  // and their number
+  struct TryCatchResumeHandler* resumeHandlers;
+  int nbResumeHandler;
+
+  // Flag to memorise if the cancellation of the context is pending
+  _Atomic bool isCancelPending;
+
+// pthread_kill is POSIX only, guard against this.
+#if TryCatchPosix
+
+  // Flag to memorise if the context is attached to a thread
+  _Atomic bool isAttached;
+
+  // Thread to which the context is attached
+  pthread_t thread;
+
+#endif
+
+  // State of the pseudo random generator of the thread
+  uint64_t seed;
+
+};
+
+// Context and its stack of frames, allocated in one block. The context of
+// a thread is allocated at the first use of TryCatch in the thread, other
+// contexts are created with TryCatchCtxCreate for fibers. Keeping only a
+// pointer to the context in the thread local storage keeps the latter
+// small, which allows the fast initial-exec TLS model even when the
+// library is loaded as a shared object, and makes the switch of context a
+// swap of this pointer.
+struct TryCatchCtxBlock {
+
+  // Context
+  struct TryCatchCtx ctx;
+
+  // Stack of frames
+  struct TryCatchFrame frames[];
+
+};
+
+// Context attached to the current thread, NULL until its first use or
+// after TryCatchCtxAttach(NULL)
+static _Thread_local struct TryCatchCtx* tryCatchCtx = NULL;
+
+// Key to free the context of a thread when it exits
+static tss_t tryCatchCtxKey;
+static once_flag tryCatchCtxKeyOnce = ONCE_FLAG_INIT;
 
 // Label for the TryCatchExceptions
 static char* exceptionStr[TryCatchExc_LastID] = {
@@ -47,6 +216,9 @@ static char* exceptionStr[TryCatchExc_LastID] = {
   "TryCatchExc_NotYetImplemented",
   "TryCatchExc_UnitTestFailed",
   "TryCatchExc_InfiniteLoop",
+  "TryCatchExc_SandboxCrashed",
+  "TryCatchExc_CircuitOpen",
+  "TryCatchExc_Cancelled",
 
 };
 
@@ -70,181 +242,3954 @@ static char const* (*userDefinedExcToStr[nbMaxUserDefinedExcToStr])(int);
 // Stream to print out a message each time Raise is called
 static FILE* streamRaise = NULL;
 
-// Function called at the beginning of a TryCatch block to guard against
-// overflow of the stack of jump_buf
-void TryCatchGuardOverflow(
-  void) {
+// Size of the table of raise sites, define how many sites can have their
+// own index
+#ifndef TryCatchMaxNbSite
+#define TryCatchMaxNbSite 4096
+#endif
 
-  // If the max level of incursion is reached
-  if (tryCatchExcLvl == TryCatchMaxExcLvl) {
+// Table of raise sites, indexed by their ID (0 is unused)
+static struct TryCatchSite* _Atomic tryCatchSites[TryCatchMaxNbSite];
 
-    // Print a message on the standard error output and exit
-    fprintf(
-      stderr,
-      "TryCatch blocks recursive incursion overflow, exiting. "
-      "(You can try to raise the value of TryCatchMaxExcLvl in trycatch.c, "
-      "it was: %d)\n",
-      TryCatchMaxExcLvl);
-    exit(EXIT_FAILURE);
+// Next ID to attribute to a raise site
+static _Atomic unsigned int tryCatchNbSite = 1;
 
-  }
+// Copies owned by TryCatchC of the descriptors of the sites forgotten by
+// TryCatchForgetSites, indexed by their ID. A copy is allocated at the
+// first time its site is forgotten and kept afterward. The ID is free to
+// be given back to an identical site while the table of raise sites
+// contains the copy.
+static struct TryCatchSite* siteCopies[TryCatchMaxNbSite];
 
-}
+// Number of IDs free to be given back to an identical site
+static _Atomic unsigned int nbSiteOrphan = 0;
 
-// Function called to get the jmp_buf on the top of the stack when
-// starting a new TryCatch block
+// Lock protecting the copies of the forgotten sites and their IDs
+static mtx_t siteForgetLock;
+static once_flag siteForgetLockOnce = ONCE_FLAG_INIT;
+
+// Max number of ranges of memory forgotten by TryCatchForgetSites which
+// can be checked, the sites recorded before more forgotten ranges are
+// considered unknown
+#ifndef TryCatchMaxNbSiteForget
+#define TryCatchMaxNbSiteForget 1024
+#endif
+
+// Range of memory forgotten by TryCatchForgetSites
+struct TryCatchSiteRange {
+
+  // Start and end (excluded) addresses of the range
+  uintptr_t start;
+  uintptr_t end;
+
+};
+
+// Ranges of memory forgotten by TryCatchForgetSites, in their order of
+// call. An entry is written once before the number of ranges is
+// incremented, hence it can be read without lock, even from a signal
+// handler.
+static struct TryCatchSiteRange siteForgetRanges[TryCatchMaxNbSiteForget];
+
+// Number of calls to TryCatchForgetSites, the site pointers kept by the
+// context and the flight recorder are stamped with it
+static _Atomic unsigned int nbSiteForget = 0;
+
+// Function to check a site pointer against the ranges of memory
+// forgotten since it has been recorded. Async-signal-safe.
+// Inputs:
+//   site: The site
+//    gen: The number of calls to TryCatchForgetSites when the site has
+//         been recorded
 // Output:
-//   Remove the jmp_buf on the top of the stack and return it
-jmp_buf* TryCatchGetJmpBufOnStackTop(
-  void) {
+//   Return the site, or NULL if its memory may have been unmapped since
+static struct TryCatchSite const* TryCatchResolveSite(
+  struct TryCatchSite const* const site,
+                unsigned int const gen) {
 
-  // Reset the last raised exception
-  tryCatchExc = 0;
+  unsigned int nbForget =
+    atomic_load_explicit(
+      &nbSiteForget,
+      memory_order_acquire);
+  if (site == NULL || gen == nbForget) return site;
+  uintptr_t ptr = (uintptr_t)site;
+  for (
+    unsigned int iForget = gen;
+    iForget < nbForget;
+    ++iForget) {
 
-  // Memorise the current jmp_buf at the top of the stack
-  jmp_buf* topStack = tryCatchExcJmp + tryCatchExcLvl;
+    if (iForget >= TryCatchMaxNbSiteForget) return NULL;
+    struct TryCatchSiteRange const* range = siteForgetRanges + iForget;
+    if (ptr >= range->start && ptr < range->end) return NULL;
 
-  // Move the index of the top of the stack of jmp_buf to the upper level
-  tryCatchExcLvl++;
+  }
 
-  // Return the jmp_buf previously at the top of the stack
-  return topStack;
+  return site;
 
 }
 
-// Function called to raise the TryCatchException 'exc'
-// Inputs:
-//        exc: The TryCatchException to raise. Do not use the type enum
-//             TryCatchException to allow the user to extend the list of
-//             exceptions with user-defined exception outside of enum
-//             TryCatchException.
-//   filename: File where the exception has been raised
-//       line: Line where the exception has been raised
-void Raise_(
-                int exc,
-  char const* const filename,
-          int const line) {
+// Counter to attribute the thread IDs
+static _Atomic uint32_t tryCatchNbThread = 0;
 
-  // If the stream to record exception raising is set and the raised
-  // exception do not come from trycatch.c (to avoid unnecessary
-  // repeatition in the trace), print the exception
-  // on the stream
-  bool retStrCmp =
-    strcmp(
-      filename,
-      __FILE__);
-  if (streamRaise != NULL && retStrCmp != 0)
-    fprintf(
-      streamRaise,
-      "Exception (%s) raised in %s, line %d.\n",
-      TryCatchExcToStr(exc),
-      filename,
-      line);
-  if (tryCatchExcLvl > 0) {
+// ID of the thread in the traces, 0 if not yet attributed
+static _Thread_local uint32_t tryCatchThreadId = 0;
 
-    // Memorise the last raised exception to be able to handle it if
-    // it reaches the default case in the swith statement of the TryCatch
-    // block
-    tryCatchExc = exc;
+// Size of the ring of events of the flight recorder of each thread
+#ifndef TryCatchFlightRecorderSize
+#define TryCatchFlightRecorderSize 64
+#endif
+
+// Max number of threads simultaneously recorded by the flight recorder
+#ifndef TryCatchMaxNbFlightThread
+#define TryCatchMaxNbFlightThread 64
+#endif
 
-    // Get the level in the stack where to jump back
-    int jumpTo = (tryCatchExcLvl > 0 ? tryCatchExcLvl - 1 : 0);
+// Kinds of events recorded by the flight recorder
+enum TryCatchFlightKind {
 
-    // Call longjmp with the appropriate jmp_buf in the stack and the
-    // raised TryCatchException.
-    longjmp(
-      tryCatchExcJmp[jumpTo],
-      exc);
+  TryCatchFlightKind_Enter,
+  TryCatchFlightKind_Exit,
+  TryCatchFlightKind_Raise,
+  TryCatchFlightKind_Catch,
+  TryCatchFlightKind_Resume
 
-  }
+};
+
+// Label for the TryCatchFlightKind
+static char const* flightKindStr[] = {
+
+  "enter",
+  "exit",
+  "raise",
+  "catch",
+  "resume"
+
+};
+
+// Event recorded by the flight recorder
+struct TryCatchFlightEvent {
+
+  // Time of the event in nanoseconds since the Epoch
+  uint64_t timestamp;
+
+  // Site of the raise (NULL if unknown or not a raise), and the number of
+  // calls to TryCatchForgetSites when it has been recorded
+  struct TryCatchSite const* site;
+  unsigned int siteGen;
+
+  // Exception (0 if none)
+  int exc;
+
+  // Level in the stack of TryCatch blocks
+  int level;
+
+  // Kind of event
+  enum TryCatchFlightKind kind;
+
+};
+
+// Ring of the last events of a thread for the flight recorder. It is
+// written with plain stores by its thread only.
+struct TryCatchFlightRing {
+
+  // Events, the last one is at index (nbEvent - 1) % size
+  struct TryCatchFlightEvent events[TryCatchFlightRecorderSize];
+
+  // Total number of recorded events
+  unsigned long nbEvent;
+
+  // ID of the thread
+  uint32_t threadId;
+
+  // Flag to memorise if the ring is attributed to a thread
+  _Atomic bool isUsed;
+
+};
+
+// Pool of rings of the flight recorder
+static struct TryCatchFlightRing flightRings[TryCatchMaxNbFlightThread];
+
+// Ring of the current thread, NULL if not yet attributed
+static _Thread_local struct TryCatchFlightRing* flightRing = NULL;
+
+// Flag to memorise if the attribution of a ring to the current thread
+// has failed
+static _Thread_local bool flightRingUnavailable = false;
+
+// Key to release the ring of a thread when it exits
+static tss_t flightRingKey;
+static once_flag flightRingKeyOnce = ONCE_FLAG_INIT;
+
+// Flag to memorise if the flight recorder is on, read with relaxed loads
+// by the TryCatch blocks of all the threads
+static _Atomic bool flightRecorderOn = false;
+
+// Number of sub-buckets per power of 2 in the latency histograms, as a
+// power of 2, and number of buckets in the histograms
+#define TryCatchLatencySubBits 3
+#define TryCatchLatencyNbBucket \
+  ((64 - TryCatchLatencySubBits + 1) << TryCatchLatencySubBits)
+
+// Latency histogram of a site in one thread. It is written by its thread
+// only, the counters are atomic to be read by the other threads.
+struct TryCatchLatencyHist {
+
+  // Number of samples per bucket
+  _Atomic uint64_t counts[TryCatchLatencyNbBucket];
+
+  // Sum of the samples, in nanoseconds
+  _Atomic uint64_t sum;
+
+};
+
+// Latency histograms of a thread, indexed by site and kind of latency.
+// Tables are never freed, the table of an exiting thread is reused by
+// the next new thread and its samples are kept.
+struct TryCatchLatencyTable {
+
+  // Histograms, allocated at their first sample
+  struct TryCatchLatencyHist* _Atomic hists[TryCatchMaxNbSite + 1]
+    [TryCatchLatencyKind_LastID];
+
+  // Next table in the list of all the tables
+  struct TryCatchLatencyTable* next;
+
+  // Flag to memorise if the table is attributed to a thread
+  _Atomic bool isUsed;
+
+};
+
+// List of all the latency tables
+static struct TryCatchLatencyTable* _Atomic latencyTables = NULL;
+
+// Latency table of the current thread, NULL if not yet attributed
+static _Thread_local struct TryCatchLatencyTable* latencyTable = NULL;
+
+// Key to release the latency table of a thread when it exits
+static tss_t latencyTableKey;
+static once_flag latencyTableKeyOnce = ONCE_FLAG_INIT;
+
+// Sampling period of the TryTimed blocks, 0 if the sampling is off
+static _Atomic unsigned int latencyPeriod = 0;
+
+// Number of TryTimed blocks entered by the current thread since the last
+// sampled one
+static _Thread_local unsigned int latencyCount = 0;
+
+// Max number of fault injection rules
+#ifndef TryCatchMaxNbInjectionRule
+#define TryCatchMaxNbInjectionRule 64
+#endif
+
+// Fault injection rule
+struct TryCatchInjectionRule {
+
+  // File of the sites (all files if empty)
+  char filename[256];
+
+  // Line of the sites (all lines if 0)
+  int line;
+
+  // Injected exception
+  int exc;
+
+  // Probability of injection (used if every is 0)
+  double probability;
+
+  // Period of injection
+  uint64_t every;
+
+  // Number of times the sites of the rule have been reached
+  _Atomic uint64_t nbReach;
+
+};
+
+// Fault injection rules
+static struct TryCatchInjectionRule injectionRules[TryCatchMaxNbInjectionRule];
+
+// Number of fault injection rules
+static _Atomic int nbInjectionRule = 0;
+
+// Flag to memorise if the fault injection is on, tested by
+// TryCatchInjectionPoint before anything else
+_Atomic bool tryCatchInjectionOn = false;
+
+// Seed of the pseudo random generators of the fault injection, and its
+// generation, incremented each time the seed is set
+static _Atomic uint64_t injectionSeed = 1;
+static _Atomic unsigned int injectionSeedGen = 1;
+
+// State of the pseudo random generator of the fault injection in the
+// current thread, and the generation of the seed it has been seeded
+// with, 0 until its first use
+static _Thread_local uint64_t injectionRand = 0;
+static _Thread_local unsigned int injectionRandGen = 0;
+
+// Function to get the current time in nanoseconds
+// Output:
+//   Return the time in nanoseconds since the Epoch
+static uint64_t TryCatchGetTimeNs(
+  void) {
+
+  // Get the time and convert it
+  struct timespec ts;
+  timespec_get(
+    &ts,
+    TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
 
 }
 
-// Function called when entering a catch block
-void TryCatchEnterCatchBlock(
+// Function to get the current time for the latency histograms, from a
+// monotonic clock if available
+// Output:
+//   Return the time in nanoseconds
+static uint64_t TryCatchGetClockNs(
   void) {
 
-  // Update the flag
-  flagInCatchBlock[tryCatchExcLvl - 1] = true;
+// clock_gettime is POSIX only, guard against this.
+#if TryCatchPosix
+
+  struct timespec ts;
+  clock_gettime(
+    CLOCK_MONOTONIC,
+    &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+#else
+
+  return TryCatchGetTimeNs();
+
+#endif
 
 }
 
-// Function called when exiting a catch block
-void TryCatchExitCatchBlock(
+// Function to get the ID of the current thread in the traces
+// Output:
+//   Return the ID, attributed at first call, starting at 1
+static uint32_t TryCatchGetThreadId(
   void) {
 
-  // Update the flag
-  flagInCatchBlock[tryCatchExcLvl] = false;
+  // Attribute the ID if necessary and return it
+  if (tryCatchThreadId == 0)
+    tryCatchThreadId = atomic_fetch_add(&tryCatchNbThread, 1) + 1;
+  return tryCatchThreadId;
 
 }
 
-// Function called at the end of a TryCatch block
-void TryCatchEnd(
+// Function called at the exit of a thread to release its ring of the
+// flight recorder
+// Input:
+//   ring: The ring
+static void TryCatchFlightReleaseRing(
+  void* ring) {
+
+  atomic_store(
+    &(((struct TryCatchFlightRing*)ring)->isUsed),
+    false);
+
+}
+
+// Function to create the key used to release the rings of the flight
+// recorder
+static void TryCatchFlightCreateKey(
   void) {
 
-  // The execution has reached the end of the current TryCatch block,
-  // move back to the lower level in the stack of jmp_buf
-  if (tryCatchExcLvl > 0) tryCatchExcLvl--;
+  tss_create(
+    &flightRingKey,
+    TryCatchFlightReleaseRing);
 
 }
 
-// The struct siginfo_t used to handle the SIGSEV is not defined in
-// ANSI C, guard against this.
-#ifndef __STRICT_ANSI__
+// Function to record an event in the flight recorder of the current thread
+// Inputs:
+//    kind: The kind of event
+//     exc: The exception (0 if none)
+//    site: The site of the raise (NULL if unknown or not a raise)
+//   level: The level in the stack of TryCatch blocks
+static void TryCatchFlightRecord(
+   enum TryCatchFlightKind const kind,
+                       int const exc,
+  struct TryCatchSite const* const site,
+                       int const level) {
+
+  // Attribute a ring to the thread if necessary
+  struct TryCatchFlightRing* ring = flightRing;
+  if (ring == NULL) {
 
-// Handler function to raise the exception TryCatchExc_Segv when
-// receiving the signal SIGSEV.
+    if (flightRingUnavailable) return;
+    for (
+      int iRing = 0;
+      iRing < TryCatchMaxNbFlightThread && ring == NULL;
+      ++iRing) {
+
+      bool isUsed = false;
+      if (
+        atomic_compare_exchange_strong(
+          &(flightRings[iRing].isUsed),
+          &isUsed,
+          true)) {
+
+        ring = flightRings + iRing;
+
+      }
+
+    }
+
+    if (ring == NULL) {
+
+      flightRingUnavailable = true;
+      return;
+
+    }
+
+    ring->nbEvent = 0;
+    ring->threadId = TryCatchGetThreadId();
+    tss_set(
+      flightRingKey,
+      ring);
+    flightRing = ring;
+
+  }
+
+  // Record the event
+  struct TryCatchFlightEvent* event =
+    ring->events + ring->nbEvent % TryCatchFlightRecorderSize;
+  event->timestamp = TryCatchGetTimeNs();
+  event->site = site;
+  event->siteGen =
+    atomic_load_explicit(
+      &nbSiteForget,
+      memory_order_relaxed);
+  event->exc = exc;
+  event->level = level;
+  event->kind = kind;
+  ++(ring->nbEvent);
+
+}
+
+// Function to write a string on the standard error output. It is
+// async-signal-safe on POSIX platforms. Without the POSIX features it
+// falls back on fwrite, which is not, but then it's never called from a
+// signal handler as the handlers are POSIX features too.
 // Inputs:
-//   signal: Received signal, will always be SIGSEV, unused
-//       si: Info about the signal, unused
-//      arg: Optional arguments, unused
-void TryCatchSigSegvHandler(
-         int signal,
-  siginfo_t* si,
-       void* arg) {
+//   str: The string
+//   len: The length of the string
+static void TryCatchFlightWrite(
+  char const* const str,
+       size_t const len) {
 
-  // Unused parameters
-  (void)signal; (void)si; (void)arg;
+// write is POSIX only, guard against this.
+#if TryCatchPosix
+
+  ssize_t ret =
+    write(
+      STDERR_FILENO,
+      str,
+      len);
+  (void)ret;
+
+#else
+
+  fwrite(
+    str,
+    1,
+    len,
+    stderr);
 
-  // Raise the exception
-  Raise(TryCatchExc_Segv);
+#endif
 
 }
 
-// Function to set the handler function of the signal SIGSEV and raise
-// TryCatchExc_Segv upon reception of this signal. Must have been
-// called before using Catch(TryCatchExc_Segv)
-void TryCatchInitHandlerSigSegv(
-  void) {
+// Function to append a string to a line buffer without overflowing it
+// Inputs:
+//   line: The line buffer (of size 256)
+//    len: The current length of the line, updated
+//    str: The string to append
+static void TryCatchFlightAppendStr(
+        char* const line,
+      size_t* const len,
+  char const* const str) {
 
-  // Create a struct sigaction to set the handler
-  struct sigaction sigActionSegv;
-  memset(
-    &sigActionSegv,
-    0,
-    sizeof(struct sigaction));
-  sigemptyset(&(sigActionSegv.sa_mask));
-  sigActionSegv.sa_sigaction = TryCatchSigSegvHandler;
-  sigActionSegv.sa_flags = SA_SIGINFO;
+  for (
+    char const* ptr = str;
+    *ptr != '\0' && *len < 255;
+    ++ptr) {
 
-  // Set the handler
-  sigaction(
-    SIGSEGV,
-    &sigActionSegv,
-    NULL);
+    line[*len] = *ptr;
+    ++(*len);
+
+  }
 
 }
 
-#endif
+// Function to append an unsigned integer to a line buffer without
+// overflowing it
+// Inputs:
+//     line: The line buffer (of size 256)
+//      len: The current length of the line, updated
+//      val: The integer to append
+//   minLen: The minimum number of digits (padded with 0)
+static void TryCatchFlightAppendUInt(
+    char* const line,
+  size_t* const len,
+       uint64_t val,
+      int const minLen) {
 
-// Function to get the ID of the last raised exception
-// Output:
-//   Return the id of the last raised exception
-int TryCatchGetLastExc(
-  void) {
+  char digits[24];
+  int nbDigit = 0;
+  do {
+
+    digits[nbDigit] = (char)('0' + val % 10);
+    ++nbDigit;
+    val /= 10;
+
+  } while (val > 0 || nbDigit < minLen);
+  while (nbDigit > 0 && *len < 255) {
+
+    --nbDigit;
+    line[*len] = digits[nbDigit];
+    ++(*len);
+
+  }
+
+}
+
+// Function to dump the ring of the flight recorder of a thread on the
+// standard error output, in an async-signal-safe way (except when the
+// POSIX features are left out)
+// Input:
+//   ring: The ring
+static void TryCatchFlightDumpRing(
+  struct TryCatchFlightRing const* const ring) {
+
+  char line[256];
+  size_t len = 0;
+  TryCatchFlightAppendStr(
+    line,
+    &len,
+    "--- TryCatch flight recorder, thread ");
+  TryCatchFlightAppendUInt(
+    line,
+    &len,
+    ring->threadId,
+    1);
+  TryCatchFlightAppendStr(
+    line,
+    &len,
+    " ---\n");
+  TryCatchFlightWrite(
+    line,
+    len);
+
+  // Loop on the events from the oldest one
+  unsigned long nbEvent = ring->nbEvent;
+  unsigned long iEvent =
+    (nbEvent > TryCatchFlightRecorderSize ?
+      nbEvent - TryCatchFlightRecorderSize : 0);
+  for (; iEvent < nbEvent; ++iEvent) {
+
+    struct TryCatchFlightEvent const* event =
+      ring->events + iEvent % TryCatchFlightRecorderSize;
+    len = 0;
+    TryCatchFlightAppendUInt(
+      line,
+      &len,
+      event->timestamp / 1000000000u,
+      1);
+    TryCatchFlightAppendStr(
+      line,
+      &len,
+      ".");
+    TryCatchFlightAppendUInt(
+      line,
+      &len,
+      event->timestamp % 1000000000u,
+      9);
+    TryCatchFlightAppendStr(
+      line,
+      &len,
+      " level ");
+    TryCatchFlightAppendUInt(
+      line,
+      &len,
+      (uint64_t)event->level,
+      1);
+    TryCatchFlightAppendStr(
+      line,
+      &len,
+      " ");
+    TryCatchFlightAppendStr(
+      line,
+      &len,
+      flightKindStr[event->kind]);
+
+    // Exception, converted with the default labels only as user-defined
+    // conversion functions are not async-signal-safe
+    if (event->exc != 0) {
+
+      TryCatchFlightAppendStr(
+        line,
+        &len,
+        " exception (");
+      if (event->exc > 0 && event->exc < TryCatchExc_LastID) {
+
+        TryCatchFlightAppendStr(
+          line,
+          &len,
+          exceptionStr[event->exc]);
+
+      } else {
+
+        if (event->exc < 0) {
+
+          TryCatchFlightAppendStr(
+            line,
+            &len,
+            "-");
+
+        }
+
+        TryCatchFlightAppendUInt(
+          line,
+          &len,
+          (uint64_t)(event->exc < 0 ? -(int64_t)event->exc : event->exc),
+          1);
+
+      }
+
+      TryCatchFlightAppendStr(
+        line,
+        &len,
+        ")");
+
+    }
+
+    struct TryCatchSite const* site =
+      TryCatchResolveSite(
+        event->site,
+        event->siteGen);
+    if (site != NULL) {
+
+      TryCatchFlightAppendStr(
+        line,
+        &len,
+        " in ");
+      TryCatchFlightAppendStr(
+        line,
+        &len,
+        site->filename);
+      TryCatchFlightAppendStr(
+        line,
+        &len,
+        ", line ");
+      TryCatchFlightAppendUInt(
+        line,
+        &len,
+        (uint64_t)site->line,
+        1);
+
+    }
+
+    TryCatchFlightAppendStr(
+      line,
+      &len,
+      "\n");
+    TryCatchFlightWrite(
+      line,
+      len);
+
+  }
+
+}
+
+// Function to dump the flight recorder of all the threads on the standard
+// error output. It is async-signal-safe, except when the POSIX features
+// are left out.
+void TryCatchDumpFlightRecorder(
+  void) {
+
+  // Loop on the rings in use
+  for (
+    int iRing = 0;
+    iRing < TryCatchMaxNbFlightThread;
+    ++iRing) {
+
+    if (atomic_load(&(flightRings[iRing].isUsed)))
+      TryCatchFlightDumpRing(flightRings + iRing);
+
+  }
+
+}
+
+// Function called at the exit of a thread to free its context
+// Input:
+//   ctx: The context
+static void TryCatchFreeThreadCtx(
+  void* ctx) {
+
+  // Detach the context before freeing it, a TryCatch block used later by
+  // another destructor of the thread then gets a new context
+  struct TryCatchCtx* that = ctx;
+  tryCatchCtx = NULL;
+  TryCatchCtxFree(&that);
+
+}
+
+// Function to create the key used to free the context of exiting threads
+static void TryCatchCreateCtxKey(
+  void) {
+
+  tss_create(
+    &tryCatchCtxKey,
+    TryCatchFreeThreadCtx);
+
+}
+
+// Function to create a context, for example for a fiber, independent of
+// the context of the thread. It can be attached to any thread with
+// TryCatchCtxAttach, one thread at a time.
+// Input:
+//   maxLvl: The maximum number of nested TryCatch blocks in the context
+// Output:
+//   Return the context, or NULL if it couldn't be allocated
+struct TryCatchCtx* TryCatchCtxCreate(
+  int const maxLvl) {
+
+  // Allocate memory for the context and its frames
+  if (maxLvl <= 0) return NULL;
+  struct TryCatchCtxBlock* block =
+    malloc(
+      sizeof(struct TryCatchCtxBlock) +
+      (size_t)maxLvl * sizeof(struct TryCatchFrame));
+  if (block == NULL) return NULL;
+
+  // Initialise the context
+  block->ctx = (struct TryCatchCtx){
+    .frames = block->frames,
+    .maxLvl = maxLvl,
+    .lvl = 0,
+    .exc = 0,
+    .site = NULL,
+    .siteGen = 0,
+    .nextFilter = NULL,
+    .nextRetryMax = 0,
+    .nextRetryPolicy = NULL,
+    .nextBreaker = NULL,
+    .nextIsTransaction = false,
+    .nextTimedSite = NULL,
+    .nbTransaction = 0,
+    .undo = NULL,
+    .undoSize = 0,
+    .undoCapacity = 0,
+    .resumeHandlers = NULL,
+    .nbResumeHandler = 0,
+    .isCancelPending = false,
+    .seed =
+      (TryCatchGetTimeNs() ^ ((uint64_t)TryCatchGetThreadId() << 32)) | 1u
+  };
+
+  // Return the context
+  return &(block->ctx);
+
+}
+
+// Function to free a context created with TryCatchCtxCreate. It must not
+// be attached to a thread.
+// Input:
+//   ctx: The context, set to NULL on return
+void TryCatchCtxFree(
+  struct TryCatchCtx** const ctx) {
+
+  if (ctx == NULL || *ctx == NULL) return;
+
+  // The context is the first member of its block
+  free((*ctx)->undo);
+  free((*ctx)->resumeHandlers);
+  free(*ctx);
+  *ctx = NULL;
+
+}
+
+// Function to attach a context to the current thread
+// Input:
+//   ctx: The context
+static void TryCatchCtxBind(
+  struct TryCatchCtx* const ctx) {
+
+  tryCatchCtx = ctx;
+
+// pthread_kill is POSIX only, guard against this.
+#if TryCatchPosix
+
+  // Memorise the thread to interrupt it when the context is cancelled
+  ctx->thread = pthread_self();
+  atomic_store(
+    &(ctx->isAttached),
+    true);
+
+#endif
+
+}
+
+// Function to attach the context of the current thread, creating it at
+// its first use
+// Output:
+//   Return the context
+static struct TryCatchCtx* TryCatchAttachThreadCtx(
+  void) {
+
+  // Get the context of the thread
+  call_once(
+    &tryCatchCtxKeyOnce,
+    TryCatchCreateCtxKey);
+  struct TryCatchCtx* ctx = tss_get(tryCatchCtxKey);
+
+  // If it doesn't exist yet, create it
+  if (ctx == NULL) {
+
+    ctx = TryCatchCtxCreate(TryCatchMaxExcLvl);
+    if (ctx == NULL) {
+
+      // Print a message on the standard error output and exit
+      fprintf(
+        stderr,
+        "TryCatch couldn't allocate the context of the thread, exiting.\n");
+      exit(EXIT_FAILURE);
+
+    }
+
+    tss_set(
+      tryCatchCtxKey,
+      ctx);
+
+  }
+
+  // Attach the context and return it
+  TryCatchCtxBind(ctx);
+  return ctx;
+
+}
+
+// Function to get the context of TryCatch blocks of the current thread, to
+// be used with the ...Ctx functions and macros
+// Output:
+//   Return the context
+struct TryCatchCtx* TryCatchGetCtx(
+  void) {
+
+  // Attach the context of the thread if none is attached
+  struct TryCatchCtx* ctx = tryCatchCtx;
+  if (ctx == NULL) ctx = TryCatchAttachThreadCtx();
+
+  // Return the context
+  return ctx;
+
+}
+
+// Function to attach a context to the current thread, replacing the one
+// currently attached. Used by fiber schedulers, the switch is a swap of
+// pointer: the context of the fiber being suspended is detached and the
+// one of the fiber being resumed is attached.
+// Input:
+//   ctx: The context to attach, or NULL to attach back the thread's own
+//        context
+// Output:
+//   Return the context previously attached (never NULL)
+struct TryCatchCtx* TryCatchCtxAttach(
+  struct TryCatchCtx* const ctx) {
+
+  struct TryCatchCtx* prev = TryCatchGetCtx();
+
+// pthread_kill is POSIX only, guard against this.
+#if TryCatchPosix
+
+  atomic_store(
+    &(prev->isAttached),
+    false);
+
+#endif
+
+  // Attach the new context, or let TryCatchGetCtx attach the one of the
+  // thread
+  if (ctx != NULL) TryCatchCtxBind(ctx);
+  else tryCatchCtx = NULL;
+  return prev;
+
+}
+
+// Function called at the beginning of a TryCatch block to guard against
+// overflow of the stack of jump_buf
+// Input:
+//   ctx: The context
+void TryCatchCtxGuardOverflow(
+  struct TryCatchCtx* const ctx) {
+
+  // If the max level of incursion is reached
+  if (ctx->lvl == ctx->maxLvl) {
+
+    // Print a message on the standard error output and exit
+    fprintf(
+      stderr,
+      "TryCatch blocks recursive incursion overflow, exiting. "
+      "(You can try to raise the value of TryCatchMaxExcLvl in trycatch.c, "
+      "it was: %d)\n",
+      ctx->maxLvl);
+    exit(EXIT_FAILURE);
+
+  }
+
+}
+
+// Function called at the beginning of a TryCatch block to guard against
+// overflow of the stack of jump_buf
+void TryCatchGuardOverflow(
+  void) {
+
+  TryCatchCtxGuardOverflow(TryCatchGetCtx());
+
+}
+
+// Function called to get the jmp_buf on the top of the stack when
+// starting a new TryCatch block
+// Input:
+//   ctx: The context
+// Output:
+//   Remove the jmp_buf on the top of the stack and return it
+jmp_buf* TryCatchCtxGetJmpBufOnStackTop(
+  struct TryCatchCtx* const ctx) {
+
+  // Reset the last raised exception
+  ctx->exc = 0;
+  ctx->site = NULL;
+
+  // Memorise the current frame at the top of the stack
+  struct TryCatchFrame* frame = ctx->frames + ctx->lvl;
+
+  // Set the list of exceptions caught by the block
+  frame->filter = ctx->nextFilter;
+  ctx->nextFilter = NULL;
+
+  // Set the number of attempts and backoff policy of the block
+  frame->retryMax = ctx->nextRetryMax;
+  frame->retryPolicy = ctx->nextRetryPolicy;
+  frame->retryAttempt = 0;
+  ctx->nextRetryMax = 0;
+  ctx->nextRetryPolicy = NULL;
+
+  // Set the circuit breaker of the block
+  frame->breaker = ctx->nextBreaker;
+  frame->isProbe = false;
+  ctx->nextBreaker = NULL;
+
+  // Start the transaction of the block if necessary
+  frame->isTransaction = ctx->nextIsTransaction;
+  frame->undoMark = ctx->undoSize;
+  ctx->nextIsTransaction = false;
+  if (frame->isTransaction) ++(ctx->nbTransaction);
+
+  // Start the measure of the latency of the block if it's sampled
+  frame->timedSite = ctx->nextTimedSite;
+  frame->unwindStart = 0;
+  ctx->nextTimedSite = NULL;
+  if (frame->timedSite != NULL) frame->timedStart = TryCatchGetClockNs();
+
+  // Move the index of the top of the stack of frames to the upper level
+  ctx->lvl++;
+
+  // Record the entrance in the block in the flight recorder
+  if (
+    atomic_load_explicit(
+      &flightRecorderOn,
+      memory_order_relaxed))
+    TryCatchFlightRecord(
+      TryCatchFlightKind_Enter,
+      0,
+      NULL,
+      ctx->lvl);
+
+  // Return the jmp_buf previously at the top of the stack
+  return &(frame->jmp);
+
+}
+
+// Function called to get the jmp_buf on the top of the stack when
+// starting a new TryCatch block
+// Output:
+//   Remove the jmp_buf on the top of the stack and return it
+jmp_buf* TryCatchGetJmpBufOnStackTop(
+  void) {
+
+  return TryCatchCtxGetJmpBufOnStackTop(TryCatchGetCtx());
+
+}
+
+// Entry of the undo log, following the previous bytes of the logged write
+struct TryCatchUndoEntry {
+
+  // Address of the write
+  void* ptr;
+
+  // Size of the write, in bytes
+  size_t size;
+
+};
+
+// Function called at the beginning of a TryTransaction block
+void TryCatchSetNextTransaction(
+  void) {
+
+  // Memorise the flag until the block is pushed on the stack
+  TryCatchGetCtx()->nextIsTransaction = true;
+
+}
+
+// Function to save the bytes about to be modified by a write in the
+// running TryTransaction blocks, to restore them if the transaction is
+// rolled back. Does nothing outside of TryTransaction blocks.
+// TryCatchExc_MallocFailed is raised if the undo log couldn't be
+// extended.
+// Inputs:
+//    ptr: The address of the write
+//   size: The size of the write, in bytes
+void TryCatchLogWrite(
+  void const* const ptr,
+       size_t const size) {
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  if (ctx->nbTransaction == 0 || size == 0) return;
+
+  // Extend the buffer of the log if necessary
+  size_t sizeData = (size + 7u) & ~(size_t)7u;
+  size_t sizeEntry = sizeData + sizeof(struct TryCatchUndoEntry);
+  if (ctx->undoSize + sizeEntry > ctx->undoCapacity) {
+
+    size_t capacity = (ctx->undoCapacity == 0 ? 4096 : ctx->undoCapacity);
+    while (capacity < ctx->undoSize + sizeEntry) capacity *= 2;
+    unsigned char* undo =
+      realloc(
+        ctx->undo,
+        capacity);
+    if (undo == NULL) Raise(TryCatchExc_MallocFailed);
+    ctx->undo = undo;
+    ctx->undoCapacity = capacity;
+
+  }
+
+  // Append the previous bytes and the entry
+  memcpy(
+    ctx->undo + ctx->undoSize,
+    ptr,
+    size);
+  struct TryCatchUndoEntry entry = {
+    .ptr = (void*)ptr,
+    .size = size
+  };
+  memcpy(
+    ctx->undo + ctx->undoSize + sizeData,
+    &entry,
+    sizeof(entry));
+  ctx->undoSize += sizeEntry;
+
+}
+
+// Function to roll back the writes logged in the undo log after a given
+// size of the log, in reverse order, and truncate the log to this size
+// Inputs:
+//    ctx: The context
+//   mark: The size of the log to roll back to
+static void TryCatchRollback(
+  struct TryCatchCtx* const ctx,
+               size_t const mark) {
+
+  while (ctx->undoSize > mark) {
+
+    struct TryCatchUndoEntry entry;
+    memcpy(
+      &entry,
+      ctx->undo + ctx->undoSize - sizeof(entry),
+      sizeof(entry));
+    size_t sizeData = (entry.size + 7u) & ~(size_t)7u;
+    ctx->undoSize -= sizeData + sizeof(entry);
+    memcpy(
+      entry.ptr,
+      ctx->undo + ctx->undoSize,
+      entry.size);
+
+  }
+
+}
+
+// Function called at the beginning of a TryFor block to register the
+// exceptions caught by the block
+// Input:
+//   excs: The list of caught exceptions, terminated by 0. The list must
+//         stay valid until the end of the block.
+void TryCatchSetNextFilter(
+  int const* const excs) {
+
+  // Memorise the list until the block is pushed on the stack
+  TryCatchGetCtx()->nextFilter = excs;
+
+}
+
+// Function to get a pseudo random number (xorshift64*)
+// Input:
+//   seed: The state of the generator, updated on return (must not be 0)
+// Output:
+//   Return the number
+static uint64_t TryCatchRand(
+  uint64_t* const seed) {
+
+  *seed ^= *seed >> 12;
+  *seed ^= *seed << 25;
+  *seed ^= *seed >> 27;
+  return *seed * 2685821657736338717u;
+
+}
+
+// Function to get a pseudo random number uniformly distributed in [0, 1)
+// Input:
+//   seed: The state of the generator, updated on return (must not be 0)
+// Output:
+//   Return the number
+static double TryCatchRandUnit(
+  uint64_t* const seed) {
+
+  return (double)(TryCatchRand(seed) >> 11) * 0x1.0p-53;
+
+}
+
+// Function called at the beginning of a TryRetry block to register its
+// number of attempts, backoff policy and retried exceptions
+// Inputs:
+//   maxAttempts: The maximum number of attempts of the block
+//        policy: The backoff policy (can be NULL for no delay and no
+//                statistics)
+//          excs: The list of retried exceptions, terminated by 0. The list
+//                must stay valid until the end of the block.
+void TryCatchSetNextRetry(
+                         int const maxAttempts,
+  struct TryCatchRetryPolicy* const policy,
+                   int const* const excs) {
+
+  // Memorise the parameters until the block is pushed on the stack. The
+  // retried exceptions are the ones caught by the block.
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  ctx->nextFilter = excs;
+  ctx->nextRetryMax = (maxAttempts > 0 ? maxAttempts : 1);
+  ctx->nextRetryPolicy = policy;
+
+}
+
+// Function called at the beginning of each attempt of a TryRetry block,
+// waiting for the backoff delay if it is not the first attempt. The wait
+// is a checkpoint: TryCatchExc_Cancelled is raised if the cancellation of
+// the context is requested before or during the wait.
+// Input:
+//   site: Descriptor of the site of the block, where TryCatchExc_Cancelled
+//         is raised
+void TryCatchRetryAttempt(
+  struct TryCatchSite* const site) {
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  struct TryCatchFrame* frame = ctx->frames + ctx->lvl - 1;
+  struct TryCatchRetryPolicy* policy = frame->retryPolicy;
+
+  // If it's the first attempt, memorise its beginning
+  if (frame->retryAttempt == 0) {
+
+    if (policy != NULL) frame->retryStart = TryCatchGetTimeNs();
+
+  // Else, wait for the backoff delay
+  } else if (policy != NULL && policy->delay > 0) {
+
+    // Get the delay for this retry
+    double delay = (double)(policy->delay);
+    for (
+      int iRetry = 1;
+      iRetry < frame->retryAttempt;
+      ++iRetry) {
+
+      delay *= policy->factor;
+      if (policy->maxDelay > 0 && delay >= (double)(policy->maxDelay))
+        break;
+
+    }
+
+    if (policy->maxDelay > 0 && delay > (double)(policy->maxDelay))
+      delay = (double)(policy->maxDelay);
+
+    // Remove the jitter
+    delay -=
+      delay * policy->jitter * TryCatchRandUnit(&(ctx->seed));
+
+    // Sleep, resuming after interruptions by signals unless the context
+    // has been cancelled (cf. TryCatchInitCancelSignal)
+    uint64_t ns = (uint64_t)delay;
+    struct timespec ts = {
+      .tv_sec = (time_t)(ns / 1000000000u),
+      .tv_nsec = (long)(ns % 1000000000u)
+    };
+    do {
+
+      TryCatchCheckpoint_(site);
+
+    } while (
+      thrd_sleep(
+        &ts,
+        &ts) == -1);
+
+  }
+
+  // Update the number of attempts and reset the last raised exception
+  ++(frame->retryAttempt);
+  ctx->exc = 0;
+
+}
+
+// Function called at the end of a TryRetry block to update the statistics
+// of its policy
+// Inputs:
+//       frame: The frame of the block
+//   isSuccess: True if the block ended without exception
+static void TryCatchRetryEnd(
+  struct TryCatchFrame* const frame,
+                   bool const isSuccess) {
+
+  // Flag the end of the block
+  frame->retryMax = 0;
+
+  // Update the statistics
+  struct TryCatchRetryPolicy* policy = frame->retryPolicy;
+  if (policy == NULL) return;
+  uint64_t latency = TryCatchGetTimeNs() - frame->retryStart;
+  atomic_fetch_add_explicit(
+    &(policy->nbBlock),
+    1,
+    memory_order_relaxed);
+  atomic_fetch_add_explicit(
+    &(policy->nbAttempt),
+    (uint64_t)(frame->retryAttempt),
+    memory_order_relaxed);
+  if (isSuccess == false)
+    atomic_fetch_add_explicit(
+      &(policy->nbFailure),
+      1,
+      memory_order_relaxed);
+  atomic_fetch_add_explicit(
+    &(policy->sumLatency),
+    latency,
+    memory_order_relaxed);
+  uint64_t maxLatency =
+    atomic_load_explicit(
+      &(policy->maxLatency),
+      memory_order_relaxed);
+  while (
+    latency > maxLatency &&
+    atomic_compare_exchange_weak_explicit(
+      &(policy->maxLatency),
+      &maxLatency,
+      latency,
+      memory_order_relaxed,
+      memory_order_relaxed) == false);
+
+}
+
+// Macros to pack and unpack the state of a circuit breaker: mode on
+// bits 0-1, number of blocks in the window on bits 2-32, number of
+// failures in the window on bits 33-63
+#define TryCatchBreakerPack(mode, nbBlock, nbFailure) \
+  ((uint64_t)(mode) | ((uint64_t)(nbBlock) << 2) |    \
+   ((uint64_t)(nbFailure) << 33))
+#define TryCatchBreakerMode(state) \
+  ((enum TryCatchBreakerState)((state) & 3u))
+#define TryCatchBreakerNbBlock(state) \
+  ((uint32_t)(((state) >> 2) & 0x7FFFFFFFu))
+#define TryCatchBreakerNbFailure(state) \
+  ((uint32_t)((state) >> 33))
+
+// Function called at the beginning of a TryBreaker block to register its
+// circuit breaker
+// Input:
+//   breaker: The circuit breaker
+void TryCatchSetNextBreaker(
+  struct TryCatchBreaker* const breaker) {
+
+  // Memorise the breaker until the block is pushed on the stack
+  TryCatchGetCtx()->nextBreaker = breaker;
+
+}
+
+// Function called at the beginning of the code of a TryBreaker block,
+// raising TryCatchExc_CircuitOpen if the circuit is open
+// Input:
+//   site: Descriptor of the site of the block, where the exception is
+//         raised
+void TryCatchBreakerEnter(
+  struct TryCatchSite* const site) {
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  struct TryCatchFrame* frame = ctx->frames + ctx->lvl - 1;
+  struct TryCatchBreaker* breaker = frame->breaker;
+
+  // Loop until the state is stable
+  uint64_t state = atomic_load(&(breaker->state));
+  while (TryCatchBreakerMode(state) != TryCatchBreakerState_Closed) {
+
+    // If the circuit is open and its delay has expired, try to become the
+    // probe
+    if (
+      TryCatchBreakerMode(state) == TryCatchBreakerState_Open &&
+      TryCatchGetTimeNs() >= atomic_load(&(breaker->openUntil))) {
+
+      if (
+        atomic_compare_exchange_weak(
+          &(breaker->state),
+          &state,
+          TryCatchBreakerPack(TryCatchBreakerState_HalfOpen, 0, 0))) {
+
+        frame->isProbe = true;
+        return;
+
+      }
+
+    // Else, short-circuit the block, without recording its outcome
+    } else {
+
+      frame->breaker = NULL;
+      atomic_fetch_add_explicit(
+        &(breaker->nbShortCircuit),
+        1,
+        memory_order_relaxed);
+      RaiseCtx_(
+        ctx,
+        TryCatchExc_CircuitOpen,
+        site);
+
+    }
+
+  }
+
+}
+
+// Function to open a circuit
+// Input:
+//   breaker: The circuit breaker
+static void TryCatchBreakerOpen(
+  struct TryCatchBreaker* const breaker) {
+
+  // Set the end of the delay before setting the state to avoid a probe
+  // on the previous delay
+  atomic_store(
+    &(breaker->openUntil),
+    TryCatchGetTimeNs() + breaker->openDelay);
+  atomic_store(
+    &(breaker->state),
+    TryCatchBreakerPack(TryCatchBreakerState_Open, 0, 0));
+  atomic_fetch_add_explicit(
+    &(breaker->nbOpen),
+    1,
+    memory_order_relaxed);
+
+}
+
+// Function called at the end of a TryBreaker block to record its outcome
+// in its circuit breaker
+// Inputs:
+//       frame: The frame of the block
+//   isSuccess: True if the block ended without exception
+static void TryCatchBreakerEnd(
+  struct TryCatchFrame* const frame,
+                   bool const isSuccess) {
+
+  // Flag the outcome as recorded
+  struct TryCatchBreaker* breaker = frame->breaker;
+  frame->breaker = NULL;
+
+  // If the block was the probe, close or open again the circuit
+  if (frame->isProbe) {
+
+    if (isSuccess)
+      atomic_store(
+        &(breaker->state),
+        TryCatchBreakerPack(TryCatchBreakerState_Closed, 0, 0));
+    else TryCatchBreakerOpen(breaker);
+    return;
+
+  }
+
+  // Add the outcome to the window, the block which completes the window
+  // checks the failure rate and starts a new window
+  uint64_t state = atomic_load(&(breaker->state));
+  uint64_t newState = 0;
+  bool isOpening = false;
+  do {
+
+    // If the circuit has been opened by another block meanwhile, discard
+    // the outcome
+    if (TryCatchBreakerMode(state) != TryCatchBreakerState_Closed) return;
+
+    uint32_t nbBlock = TryCatchBreakerNbBlock(state) + 1;
+    uint32_t nbFailure =
+      TryCatchBreakerNbFailure(state) + (isSuccess ? 0 : 1);
+    isOpening = false;
+    if (nbBlock >= breaker->window) {
+
+      isOpening =
+        ((double)nbFailure >= breaker->threshold * (double)nbBlock);
+      nbBlock = 0;
+      nbFailure = 0;
+
+    }
+
+    newState =
+      TryCatchBreakerPack(TryCatchBreakerState_Closed, nbBlock, nbFailure);
+
+  } while (
+    atomic_compare_exchange_weak(
+      &(breaker->state),
+      &state,
+      newState) == false);
+
+  if (isOpening) TryCatchBreakerOpen(breaker);
+
+}
+
+// Function to get the state of a circuit breaker
+// Input:
+//   breaker: The circuit breaker
+// Output:
+//   Return the state
+enum TryCatchBreakerState TryCatchGetBreakerState(
+  struct TryCatchBreaker* const breaker) {
+
+  return TryCatchBreakerMode(atomic_load(&(breaker->state)));
+
+}
+
+// Function to get the statistics of a backoff policy
+// Input:
+//   policy: The backoff policy
+// Output:
+//   Return a snapshot of the statistics
+struct TryCatchRetryStats TryCatchGetRetryStats(
+  struct TryCatchRetryPolicy* const policy) {
+
+  return (struct TryCatchRetryStats){
+    .nbBlock = atomic_load(&(policy->nbBlock)),
+    .nbAttempt = atomic_load(&(policy->nbAttempt)),
+    .nbFailure = atomic_load(&(policy->nbFailure)),
+    .sumLatency = atomic_load(&(policy->sumLatency)),
+    .maxLatency = atomic_load(&(policy->maxLatency))
+  };
+
+}
+
+// Function called at the exit of a thread to release its latency table
+// Input:
+//   table: The table
+static void TryCatchLatencyReleaseTable(
+  void* table) {
+
+  atomic_store(
+    &(((struct TryCatchLatencyTable*)table)->isUsed),
+    false);
+
+}
+
+// Function to create the key used to release the latency tables
+static void TryCatchLatencyCreateKey(
+  void) {
+
+  tss_create(
+    &latencyTableKey,
+    TryCatchLatencyReleaseTable);
+
+}
+
+// Function to get the index of the bucket of a latency in the histograms.
+// Latencies lower than 2^TryCatchLatencySubBits have their own bucket,
+// then each power of 2 is divided in 2^TryCatchLatencySubBits buckets.
+// Input:
+//   latency: The latency in nanoseconds
+// Output:
+//   Return the index of the bucket
+static int TryCatchLatencyBucket(
+  uint64_t const latency) {
+
+  // Get the position of the highest bit set
+  int msb = 0;
+  uint64_t val = latency;
+  for (
+    int shift = 32;
+    shift > 0;
+    shift /= 2) {
+
+    if ((val >> shift) != 0) {
+
+      val >>= shift;
+      msb += shift;
+
+    }
+
+  }
+
+  // Get the index of the bucket
+  if (msb < TryCatchLatencySubBits) return (int)latency;
+  return
+    ((msb - TryCatchLatencySubBits + 1) << TryCatchLatencySubBits) +
+    (int)((latency >> (msb - TryCatchLatencySubBits)) &
+      ((1u << TryCatchLatencySubBits) - 1));
+
+}
+
+// Function to get the upper bound of a bucket of the histograms
+// Input:
+//   bucket: The index of the bucket
+// Output:
+//   Return the highest latency in the bucket, in nanoseconds
+static uint64_t TryCatchLatencyBucketMax(
+  int const bucket) {
+
+  if (bucket < (2 << TryCatchLatencySubBits)) return (uint64_t)bucket;
+  int shift = (bucket >> TryCatchLatencySubBits) - 1;
+  uint64_t low =
+    (uint64_t)((1 << TryCatchLatencySubBits) +
+      (bucket & ((1 << TryCatchLatencySubBits) - 1))) << shift;
+  return low + ((uint64_t)1 << shift) - 1;
+
+}
+
+// Function to record a sample in the latency histogram of a site for the
+// current thread
+// Inputs:
+//      site: The site
+//      kind: The kind of latency
+//   latency: The latency in nanoseconds
+static void TryCatchLatencyRecord(
+         struct TryCatchSite* const site,
+  enum TryCatchLatencyKind const kind,
+                    uint64_t const latency) {
+
+  // Attribute a table to the thread if necessary, reusing the one of an
+  // exited thread if possible
+  struct TryCatchLatencyTable* table = latencyTable;
+  if (table == NULL) {
+
+    call_once(
+      &latencyTableKeyOnce,
+      TryCatchLatencyCreateKey);
+    for (
+      table = atomic_load(&latencyTables);
+      table != NULL;
+      table = table->next) {
+
+      bool isUsed = false;
+      if (
+        atomic_compare_exchange_strong(
+          &(table->isUsed),
+          &isUsed,
+          true)) {
+
+        break;
+
+      }
+
+    }
+
+    if (table == NULL) {
+
+      table = calloc(1, sizeof(struct TryCatchLatencyTable));
+      if (table == NULL) return;
+      atomic_init(&(table->isUsed), true);
+      table->next = atomic_load(&latencyTables);
+      while (
+        atomic_compare_exchange_weak(
+          &latencyTables,
+          &(table->next),
+          table) == false);
+
+    }
+
+    tss_set(
+      latencyTableKey,
+      table);
+    latencyTable = table;
+
+  }
+
+  // Get the histogram, allocating it at its first sample
+  unsigned int id = TryCatchGetSiteId(site);
+  struct TryCatchLatencyHist* hist =
+    atomic_load_explicit(
+      &(table->hists[id][kind]),
+      memory_order_relaxed);
+  if (hist == NULL) {
+
+    hist = calloc(1, sizeof(struct TryCatchLatencyHist));
+    if (hist == NULL) return;
+    atomic_store_explicit(
+      &(table->hists[id][kind]),
+      hist,
+      memory_order_release);
+
+  }
+
+  // Update the histogram, its only writer is the current thread
+  _Atomic uint64_t* count = hist->counts + TryCatchLatencyBucket(latency);
+  atomic_store_explicit(
+    count,
+    atomic_load_explicit(count, memory_order_relaxed) + 1,
+    memory_order_relaxed);
+  atomic_store_explicit(
+    &(hist->sum),
+    atomic_load_explicit(&(hist->sum), memory_order_relaxed) + latency,
+    memory_order_relaxed);
+
+}
+
+// Function called at the beginning of a TryTimed block to register its
+// site, if the block is sampled
+// Input:
+//   site: The site of the block
+void TryCatchSetNextTimed(
+  struct TryCatchSite* const site) {
+
+  // Sample one block out of the sampling period
+  unsigned int period =
+    atomic_load_explicit(
+      &latencyPeriod,
+      memory_order_relaxed);
+  if (period == 0) return;
+  ++latencyCount;
+  if (latencyCount < period) return;
+  latencyCount = 0;
+
+  // Memorise the site until the block is pushed on the stack
+  TryCatchGetCtx()->nextTimedSite = site;
+
+}
+
+// Function to set the sampling of the latencies of the TryTimed blocks.
+// Each thread samples one TryTimed block out of 'period' it enters,
+// which bounds the overhead on hot sites. The sampling is off by
+// default. The samples are recorded in log-linear histograms (relative
+// precision of 1/8) per thread and per site, merged when read.
+// Input:
+//   period: The sampling period, 1 to sample all the blocks, 0 to turn
+//           off the sampling
+void TryCatchSetLatencySampling(
+  unsigned int const period) {
+
+  atomic_store(
+    &latencyPeriod,
+    period);
+
+}
+
+// Function to get the latency histogram of a site, merged over all
+// threads
+// Inputs:
+//   siteId: The index of the site (see TryCatchGetSiteId)
+//     kind: The kind of latency
+// Output:
+//   Return a snapshot of the statistics of the histogram
+struct TryCatchLatencyStats TryCatchGetLatencyStats(
+                unsigned int const siteId,
+  enum TryCatchLatencyKind const kind) {
+
+  struct TryCatchLatencyStats stats = {0};
+  if (siteId > TryCatchMaxNbSite || kind >= TryCatchLatencyKind_LastID)
+    return stats;
+
+  // Merge the histograms of all the threads
+  uint64_t counts[TryCatchLatencyNbBucket] = {0};
+  uint64_t sum = 0;
+  for (
+    struct TryCatchLatencyTable* table = atomic_load(&latencyTables);
+    table != NULL;
+    table = table->next) {
+
+    struct TryCatchLatencyHist* hist =
+      atomic_load_explicit(
+        &(table->hists[siteId][kind]),
+        memory_order_acquire);
+    if (hist == NULL) continue;
+    for (
+      int iBucket = 0;
+      iBucket < TryCatchLatencyNbBucket;
+      ++iBucket) {
+
+      uint64_t count =
+        atomic_load_explicit(
+          hist->counts + iBucket,
+          memory_order_relaxed);
+      counts[iBucket] += count;
+      stats.nbSample += count;
+
+    }
+
+    sum +=
+      atomic_load_explicit(
+        &(hist->sum),
+        memory_order_relaxed);
+
+  }
+
+  if (stats.nbSample == 0) return stats;
+  stats.mean = sum / stats.nbSample;
+
+  // Get the percentiles, as the upper bound of the bucket containing the
+  // sample at their rank
+  double const quantiles[] = {0.5, 0.99, 0.999};
+  uint64_t* percentiles[] = {&(stats.p50), &(stats.p99), &(stats.p999)};
+  int iBucket = 0;
+  uint64_t nbBelow = counts[0];
+  for (
+    int iQuantile = 0;
+    iQuantile < 3;
+    ++iQuantile) {
+
+    double pos = quantiles[iQuantile] * (double)(stats.nbSample);
+    uint64_t rank = (uint64_t)pos;
+    if ((double)rank < pos || rank < 1) ++rank;
+    while (nbBelow < rank && iBucket < TryCatchLatencyNbBucket - 1)
+      nbBelow += counts[++iBucket];
+    *(percentiles[iQuantile]) = TryCatchLatencyBucketMax(iBucket);
+
+  }
+
+  return stats;
+
+}
+
+// Function to print the statistics of the latency histograms of all the
+// sites having samples
+// Input:
+//   stream: The stream where to print
+void TryCatchDumpLatency(
+  FILE* const stream) {
+
+  // Label of the kinds of latency
+  char const* const kindStr[TryCatchLatencyKind_LastID] = {
+
+    "block",
+    "unwind"
+
+  };
+
+  // Loop on the sites, including the index shared by the sites beyond the
+  // capacity of the table of sites
+  for (
+    unsigned int siteId = 1;
+    siteId <= TryCatchMaxNbSite;
+    ++siteId) {
+
+    if (siteId == TryCatchGetNbSite() && siteId < TryCatchMaxNbSite)
+      siteId = TryCatchMaxNbSite;
+    struct TryCatchSite const* site = TryCatchGetSite(siteId);
+    for (
+      int kind = 0;
+      kind < TryCatchLatencyKind_LastID;
+      ++kind) {
+
+      struct TryCatchLatencyStats stats =
+        TryCatchGetLatencyStats(
+          siteId,
+          kind);
+      if (stats.nbSample == 0) continue;
+      fprintf(
+        stream,
+        "%s, line %d (%s): %" PRIu64 " samples, mean %" PRIu64 "ns, "
+        "p50 %" PRIu64 "ns, p99 %" PRIu64 "ns, p999 %" PRIu64 "ns\n",
+        (site != NULL ? site->filename : "?"),
+        (site != NULL ? site->line : 0),
+        kindStr[kind],
+        stats.nbSample,
+        stats.mean,
+        stats.p50,
+        stats.p99,
+        stats.p999);
+
+    }
+
+  }
+
+}
+
+// The binary trace file is based on mmap which is POSIX only, guard
+// against this.
+#if TryCatchPosix
+
+// Memory-mapped binary trace file
+struct TryCatchTraceMap {
+
+  // Mapped memory
+  unsigned char* data;
+
+  // Size of the mapped memory
+  size_t size;
+
+  // Offset in the mapped memory of the next free record
+  _Atomic size_t offset;
+
+  // Number of threads currently writing to the mapped memory
+  _Atomic int nbWriter;
+
+  // Generation of the file, incremented at each rotation
+  unsigned int gen;
+
+  // File descriptor of the file
+  int fd;
+
+};
+
+// Generation of the trace file the definition of each site has last
+// been written to, indexed by site ID
+static _Atomic unsigned int traceSiteGens[TryCatchMaxNbSite];
+
+// Mutex protecting the rotation of the file
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The two mapped files alternately used by the trace. They are never
+// freed to allow a writer to safely check if the one it has just loaded
+// is still the current one.
+static struct TryCatchTraceMap traceMaps[2];
+
+// Currently used mapped file, NULL if the binary trace is off
+static struct TryCatchTraceMap* _Atomic traceMapCur = NULL;
+
+// Path and max size of the binary trace file
+static char* tracePath = NULL;
+static size_t traceMaxSize = 0;
+
+// Function to map a new binary trace file
+// Input:
+//   map: The mapped file to initialise
+//   gen: The generation of the file
+// Output:
+//   Return true if the file could be mapped, else false
+static bool TryCatchTraceMapOpen(
+  struct TryCatchTraceMap* const map,
+                  unsigned int gen) {
+
+  // Create the file and allocate its size
+  map->fd =
+    open(
+      tracePath,
+      O_RDWR | O_CREAT | O_TRUNC,
+      0644);
+  if (map->fd < 0) return false;
+  if (ftruncate(map->fd, (off_t)traceMaxSize) != 0) {
+
+    close(map->fd);
+    return false;
+
+  }
+
+  // Map the file
+  void* data =
+    mmap(
+      NULL,
+      traceMaxSize,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED,
+      map->fd,
+      0);
+  if (data == MAP_FAILED) {
+
+    close(map->fd);
+    return false;
+
+  }
+
+  // Write the header
+  struct TryCatchTraceHeader header = {
+    .version = TryCatchTraceVersion,
+    .recordSize = sizeof(struct TryCatchTraceRecord),
+    .timestamp = TryCatchGetTimeNs(),
+    .capacity = traceMaxSize
+  };
+  memcpy(
+    header.magic,
+    TryCatchTraceMagic,
+    sizeof(header.magic));
+  memcpy(
+    data,
+    &header,
+    sizeof(header));
+
+  // Initialise the map, the number of writers is not reset as a writer
+  // may be about to check if this map is the current one
+  map->data = data;
+  map->size = traceMaxSize;
+  map->gen = gen;
+  atomic_store(
+    &(map->offset),
+    sizeof(struct TryCatchTraceHeader));
+  return true;
+
+}
+
+// Function to unmap a binary trace file once all its writers are done
+// Input:
+//   map: The mapped file
+static void TryCatchTraceMapClose(
+  struct TryCatchTraceMap* const map) {
+
+  // Wait for the writers
+  while (atomic_load(&(map->nbWriter)) > 0) sched_yield();
+
+  // Unmap the file and truncate it to the used size
+  size_t used = atomic_load(&(map->offset));
+  if (used > map->size) used = map->size;
+  munmap(
+    map->data,
+    map->size);
+  // (If it fails the unused space is simply left in the file)
+  int retTruncate =
+    ftruncate(
+      map->fd,
+      (off_t)used);
+  (void)retTruncate;
+  close(map->fd);
+
+}
+
+// Function to rotate the binary trace file
+// Input:
+//   full: The mapped file which has been found full
+static void TryCatchTraceRotate(
+  struct TryCatchTraceMap* const full) {
+
+  pthread_mutex_lock(&traceMutex);
+
+  // If another thread hasn't already rotated the file
+  if (atomic_load(&traceMapCur) == full) {
+
+    // Rename the full file, writers still write to it through the mapping
+    size_t lenPath = strlen(tracePath);
+    char* pathOld = malloc(lenPath + 3);
+    if (pathOld != NULL) {
+
+      memcpy(
+        pathOld,
+        tracePath,
+        lenPath);
+      memcpy(
+        pathOld + lenPath,
+        ".1",
+        3);
+      rename(
+        tracePath,
+        pathOld);
+      free(pathOld);
+
+    }
+
+    // Start a new file and publish it, if it fails the trace is turned off
+    struct TryCatchTraceMap* map = traceMaps + (full == traceMaps ? 1 : 0);
+    if (
+      TryCatchTraceMapOpen(
+        map,
+        full->gen + 1) == false) {
+
+      map = NULL;
+
+    }
+
+    atomic_store(
+      &traceMapCur,
+      map);
+
+    // Release the full file
+    TryCatchTraceMapClose(full);
+
+  }
+
+  pthread_mutex_unlock(&traceMutex);
+
+}
+
+// Function to reserve records in the binary trace file
+// Inputs:
+//        map: The mapped file
+//   nbRecord: The number of records
+// Output:
+//   Return a pointer to the reserved records, or NULL if the file is full
+static struct TryCatchTraceRecord* TryCatchTraceReserve(
+  struct TryCatchTraceMap* const map,
+                   size_t const nbRecord) {
+
+  size_t size = nbRecord * sizeof(struct TryCatchTraceRecord);
+  size_t offset =
+    atomic_fetch_add(
+      &(map->offset),
+      size);
+  if (offset + size > map->size) return NULL;
+  return (struct TryCatchTraceRecord*)(map->data + offset);
+
+}
+
+// Function to record a raised exception in the binary trace file
+// Inputs:
+//     exc: The raised exception
+//    site: Site where the exception has been raised
+//   level: The level in the stack of TryCatch blocks
+static void TryCatchTraceRaise(
+                        int exc,
+  struct TryCatchSite* const site,
+                  int const level) {
+
+  // Get the time and IDs for the record, sites beyond the capacity of
+  // the table of sites are recorded with the ID 0
+  uint64_t timestamp = TryCatchGetTimeNs();
+  uint32_t siteId = TryCatchGetSiteId(site);
+  if (siteId >= TryCatchMaxNbSite) siteId = 0;
+  _Atomic unsigned int* siteGen = traceSiteGens + siteId;
+
+  // Loop until the record is written or the trace turned off
+  while (true) {
+
+    // Get the current mapped file and register as a writer, checking it
+    // hasn't been rotated in between
+    struct TryCatchTraceMap* map = atomic_load(&traceMapCur);
+    if (map == NULL) return;
+    atomic_fetch_add(&(map->nbWriter), 1);
+    if (atomic_load(&traceMapCur) != map) {
+
+      atomic_fetch_sub(&(map->nbWriter), 1);
+      continue;
+
+    }
+
+    // If the site hasn't been defined yet in this file, define it
+    bool isFull = false;
+    unsigned int gen = atomic_load(siteGen);
+    if (
+      siteId != 0 &&
+      gen != map->gen &&
+      atomic_compare_exchange_strong(siteGen, &gen, map->gen)) {
+
+      // The file name is truncated to its end if it's too long, else the
+      // definition may not fit even in an empty file
+      char const* filename = site->filename;
+      size_t lenFilename = strlen(filename);
+      if (lenFilename > TryCatchTraceMaxLenFilename) {
+
+        filename += lenFilename - TryCatchTraceMaxLenFilename;
+        lenFilename = TryCatchTraceMaxLenFilename;
+
+      }
+
+      size_t nbChunk =
+        (lenFilename + sizeof(struct TryCatchTraceRecord) - 1) /
+        sizeof(struct TryCatchTraceRecord);
+      struct TryCatchTraceRecord* rec =
+        TryCatchTraceReserve(
+          map,
+          1 + nbChunk);
+      if (rec != NULL) {
+
+        memcpy(
+          rec + 1,
+          filename,
+          lenFilename);
+        *rec = (struct TryCatchTraceRecord){
+          .timestamp = timestamp,
+          .thread = (uint32_t)lenFilename,
+          .exc = site->line,
+          .site = siteId,
+          .kind = TryCatchTraceKind_Site
+        };
+
+      } else isFull = true;
+
+    }
+
+    // Write the record of the raise
+    if (isFull == false) {
+
+      struct TryCatchTraceRecord* rec =
+        TryCatchTraceReserve(
+          map,
+          1);
+      if (rec != NULL) {
+
+        *rec = (struct TryCatchTraceRecord){
+          .timestamp = timestamp,
+          .thread = TryCatchGetThreadId(),
+          .exc = exc,
+          .site = siteId,
+          .level = (uint16_t)level,
+          .kind = TryCatchTraceKind_Raise
+        };
+
+      } else isFull = true;
+
+    }
+
+    // Unregister as a writer, and rotate the file if it was full
+    atomic_fetch_sub(&(map->nbWriter), 1);
+    if (isFull == false) return;
+    TryCatchTraceRotate(map);
+
+  }
+
+}
+
+// Set the file on which to record exception raising in the compact binary
+// format, in addition to the stream set with TryCatchSetRaiseStream. The
+// file is memory-mapped and records are appended without lock. When the
+// file is full it is renamed with the suffix '.1' (replacing the previous
+// one if any) and a new file is started, hence at most twice 'maxSize'
+// bytes are used on disk. Use the tool trycatchcdecode to convert the files
+// to text.
+// Inputs:
+//      path: Path of the trace file, set it to NULL to close the current
+//            trace file
+//   maxSize: Maximum size in bytes of one file
+// Output:
+//   Return true if the file could be created, else false
+bool TryCatchSetRaiseTraceFile(
+  char const* const path,
+       size_t const maxSize) {
+
+  pthread_mutex_lock(&traceMutex);
+
+  // Close the current file if any
+  struct TryCatchTraceMap* map =
+    atomic_exchange(
+      &traceMapCur,
+      NULL);
+  if (map != NULL) TryCatchTraceMapClose(map);
+  free(tracePath);
+  tracePath = NULL;
+
+  // Open the new file if any, it must at least hold the header and the
+  // definition and raise records of one site with the longest file name,
+  // else the raise would rotate the file forever
+  bool ret = true;
+  if (path != NULL) {
+
+    size_t minSize =
+      sizeof(struct TryCatchTraceHeader) +
+      sizeof(struct TryCatchTraceRecord) *
+        (2 +
+        (TryCatchTraceMaxLenFilename +
+        sizeof(struct TryCatchTraceRecord) - 1) /
+        sizeof(struct TryCatchTraceRecord));
+    traceMaxSize = (maxSize < minSize ? minSize : maxSize);
+    tracePath = malloc(strlen(path) + 1);
+    if (tracePath != NULL) strcpy(tracePath, path);
+    unsigned int gen =
+      (traceMaps[0].gen > traceMaps[1].gen ?
+        traceMaps[0].gen : traceMaps[1].gen) + 1;
+    map = traceMaps + (map == traceMaps ? 1 : 0);
+    ret =
+      tracePath != NULL &&
+      TryCatchTraceMapOpen(
+        map,
+        gen);
+    if (ret) {
+
+      atomic_store(
+        &traceMapCur,
+        map);
+
+    }
+
+  }
+
+  pthread_mutex_unlock(&traceMutex);
+  return ret;
+
+}
+
+#endif
+
+// Function to create the lock protecting the copies of the forgotten
+// sites
+static void TryCatchCreateSiteForgetLock(
+  void) {
+
+  mtx_init(
+    &siteForgetLock,
+    mtx_plain);
+
+}
+
+// Function to check if two sites are identical
+// Inputs:
+//   siteA: The first site
+//   siteB: The second site
+// Output:
+//   Return true if the sites have the same file, line and function
+static bool TryCatchIsSameSite(
+  struct TryCatchSite const* const siteA,
+  struct TryCatchSite const* const siteB) {
+
+  return
+    siteA->line == siteB->line &&
+    strcmp(siteA->filename, siteB->filename) == 0 &&
+    strcmp(siteA->func, siteB->func) == 0;
+
+}
+
+// Function to give to a site without index the index of an identical
+// forgotten site
+// Input:
+//   site: The site
+// Output:
+//   Return the index of the site, or 0 if there is no identical forgotten
+//   site
+static unsigned int TryCatchGetOrphanSiteId(
+  struct TryCatchSite* const site) {
+
+  call_once(
+    &siteForgetLockOnce,
+    TryCatchCreateSiteForgetLock);
+  mtx_lock(&siteForgetLock);
+
+  // Loop on the indices whose site has been forgotten
+  unsigned int id = 0;
+  unsigned int nbSite = atomic_load(&tryCatchNbSite);
+  if (nbSite > TryCatchMaxNbSite) nbSite = TryCatchMaxNbSite;
+  for (
+    unsigned int iSite = 1;
+    iSite < nbSite && id == 0;
+    ++iSite) {
+
+    struct TryCatchSite* copy = siteCopies[iSite];
+    if (
+      copy != NULL &&
+      atomic_load(tryCatchSites + iSite) == copy &&
+      TryCatchIsSameSite(site, copy)) {
+
+      // Give back the index, unless another thread has attributed one to
+      // the site in between
+      unsigned int noId = 0;
+      if (
+        atomic_compare_exchange_strong(
+          &(site->id),
+          &noId,
+          iSite)) {
+
+        atomic_store(
+          tryCatchSites + iSite,
+          site);
+        atomic_fetch_sub(&nbSiteOrphan, 1);
+        id = iSite;
+
+      } else id = noId;
+
+    }
+
+  }
+
+  mtx_unlock(&siteForgetLock);
+  return id;
+
+}
+
+// Function to get the index of a raise site, attributing it if necessary.
+// Indices are attributed in order of first use, starting at 1, up to
+// TryCatchGetNbSite() - 1. Sites beyond the capacity of the table of
+// sites all share an index for which TryCatchGetSite returns NULL.
+// Input:
+//   site: The site
+// Output:
+//   Return the index of the site
+unsigned int TryCatchGetSiteId(
+  struct TryCatchSite* const site) {
+
+  // If the site already has an index, return it
+  unsigned int id =
+    atomic_load_explicit(
+      &(site->id),
+      memory_order_acquire);
+  if (id != 0) return id;
+
+  // If sites have been forgotten, give back the index of an identical
+  // one, for example from a shared library loaded again
+  if (atomic_load(&nbSiteOrphan) > 0) {
+
+    id = TryCatchGetOrphanSiteId(site);
+    if (id != 0) return id;
+
+  }
+
+  // Attribute a new index, unless the table is full in which case all the
+  // remaining sites share the index TryCatchMaxNbSite
+  unsigned int newId = TryCatchMaxNbSite;
+  if (atomic_load(&tryCatchNbSite) < TryCatchMaxNbSite) {
+
+    newId = atomic_fetch_add(&tryCatchNbSite, 1);
+    if (newId >= TryCatchMaxNbSite) {
+
+      atomic_store(&tryCatchNbSite, TryCatchMaxNbSite);
+      newId = TryCatchMaxNbSite;
+
+    }
+
+  }
+
+  // Set the index of the site, if another thread has done it in between
+  // use its index instead (the new one is left unused)
+  if (
+    atomic_compare_exchange_strong(
+      &(site->id),
+      &id,
+      newId)) {
+
+    id = newId;
+    if (id < TryCatchMaxNbSite) {
+
+      atomic_store(
+        tryCatchSites + id,
+        site);
+
+    }
+
+  }
+
+  // Return the index
+  return id;
+
+}
+
+// Function to get a raise site from its index
+// Input:
+//   id: The index of the site
+// Output:
+//   Return the site, or NULL if there is no site for this index
+struct TryCatchSite const* TryCatchGetSite(
+  unsigned int const id) {
+
+  // Return the site
+  if (id >= TryCatchMaxNbSite) return NULL;
+  return atomic_load(tryCatchSites + id);
+
+}
+
+// Function to get the number of attributed site indices
+// Output:
+//   Return the number of indices (including the unused index 0)
+unsigned int TryCatchGetNbSite(
+  void) {
+
+  // Return the number of indices
+  return atomic_load(&tryCatchNbSite);
+
+}
+
+// Function to create a copy of a site owned by TryCatchC
+// Input:
+//   site: The site
+// Output:
+//   Return the copy, or NULL if it couldn't be allocated
+static struct TryCatchSite* TryCatchCopySite(
+  struct TryCatchSite const* const site) {
+
+  // Allocate the descriptor and its strings in one block
+  size_t lenFilename = strlen(site->filename) + 1;
+  size_t lenFunc = strlen(site->func) + 1;
+  struct TryCatchSite* copy =
+    malloc(sizeof(struct TryCatchSite) + lenFilename + lenFunc);
+  if (copy == NULL) return NULL;
+  char* filename = (char*)(copy + 1);
+  char* func = filename + lenFilename;
+  memcpy(
+    filename,
+    site->filename,
+    lenFilename);
+  memcpy(
+    func,
+    site->func,
+    lenFunc);
+
+  // The members of the descriptor are constant, initialise it by copy
+  struct TryCatchSite init = {
+    filename, site->line, func, atomic_load(&(site->id))};
+  memcpy(
+    copy,
+    &init,
+    sizeof(struct TryCatchSite));
+  return copy;
+
+}
+
+// Function to forget the sites located in a range of memory about to be
+// unmapped, like a shared library before dlclose
+// Inputs:
+//   start: The start of the range
+//    size: The size of the range in bytes
+void TryCatchForgetSites(
+  void const* const start,
+       size_t const size) {
+
+  call_once(
+    &siteForgetLockOnce,
+    TryCatchCreateSiteForgetLock);
+  mtx_lock(&siteForgetLock);
+  uintptr_t rangeStart = (uintptr_t)start;
+  uintptr_t rangeEnd = rangeStart + size;
+
+  // Replace the sites of the range in the table of raise sites by their
+  // copy, or by NULL if the copy couldn't be allocated
+  unsigned int nbSite = atomic_load(&tryCatchNbSite);
+  if (nbSite > TryCatchMaxNbSite) nbSite = TryCatchMaxNbSite;
+  for (
+    unsigned int iSite = 1;
+    iSite < nbSite;
+    ++iSite) {
+
+    struct TryCatchSite* site = atomic_load(tryCatchSites + iSite);
+    uintptr_t ptr = (uintptr_t)site;
+    if (site == NULL || ptr < rangeStart || ptr >= rangeEnd) continue;
+    if (siteCopies[iSite] == NULL) siteCopies[iSite] = TryCatchCopySite(site);
+    atomic_store(
+      tryCatchSites + iSite,
+      siteCopies[iSite]);
+    if (siteCopies[iSite] != NULL) atomic_fetch_add(&nbSiteOrphan, 1);
+
+  }
+
+  // Record the range, then publish it for the site pointers recorded
+  // until now by the contexts and the flight recorder
+  unsigned int nbForget = atomic_load(&nbSiteForget);
+  if (nbForget < TryCatchMaxNbSiteForget)
+    siteForgetRanges[nbForget] = (struct TryCatchSiteRange){
+      .start = rangeStart,
+      .end = rangeEnd};
+  atomic_store_explicit(
+    &nbSiteForget,
+    nbForget + 1,
+    memory_order_release);
+  mtx_unlock(&siteForgetLock);
+
+}
+
+// Function to check if the file of a site matches the file of a fault
+// injection rule, either equal or ending with '/' followed by it
+// Inputs:
+//   filename: The file of the site
+//       rule: The file of the rule
+// Output:
+//   Return true if the files match, else false
+static bool TryCatchInjectionMatchFile(
+  char const* const filename,
+  char const* const rule) {
+
+  if (rule[0] == '\0') return true;
+  size_t len = strlen(filename);
+  size_t lenRule = strlen(rule);
+  return
+    len >= lenRule &&
+    strcmp(filename + len - lenRule, rule) == 0 &&
+    (len == lenRule || filename[len - lenRule - 1] == '/');
+
+}
+
+// Function called by TryCatchInjectionPoint when the fault injection is
+// on, raising the exception of the first rule matching the site if its
+// condition is met
+// Input:
+//   site: Descriptor of the injection point
+void TryCatchInject_(
+  struct TryCatchSite* const site) {
+
+  // Loop on the rules
+  int nbRule = atomic_load(&nbInjectionRule);
+  for (
+    int iRule = 0;
+    iRule < nbRule;
+    ++iRule) {
+
+    struct TryCatchInjectionRule* rule = injectionRules + iRule;
+    if (
+      (rule->line == 0 || rule->line == site->line) &&
+      TryCatchInjectionMatchFile(
+        site->filename,
+        rule->filename)) {
+
+      // Check the condition of the rule
+      uint64_t nbReach = atomic_fetch_add(&(rule->nbReach), 1) + 1;
+      bool isInjected = false;
+      if (rule->every > 0) {
+
+        isInjected = (nbReach % rule->every == 0);
+
+      } else {
+
+        // Seed the generator of the thread at its first use and when
+        // the seed has been set since, mixing the seed and the ID of the
+        // thread (splitmix64)
+        unsigned int gen =
+          atomic_load_explicit(
+            &injectionSeedGen,
+            memory_order_acquire);
+        if (injectionRandGen != gen) {
+
+          uint64_t x =
+            atomic_load_explicit(
+              &injectionSeed,
+              memory_order_relaxed) +
+            (uint64_t)TryCatchGetThreadId() * 0x9E3779B97F4A7C15u;
+          x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9u;
+          x = (x ^ (x >> 27)) * 0x94D049BB133111EBu;
+          x ^= x >> 31;
+          injectionRand = (x != 0 ? x : 1);
+          injectionRandGen = gen;
+
+        }
+
+        isInjected =
+          (TryCatchRandUnit(&injectionRand) < rule->probability);
+
+      }
+
+      // Raise the exception if necessary
+      if (isInjected)
+        RaiseCtx_(
+          TryCatchGetCtx(),
+          rule->exc,
+          site);
+      return;
+
+    }
+
+  }
+
+}
+
+// Function to get an exception ID from its name or its value
+// Input:
+//   str: The name or value of the exception
+// Output:
+//   Return the ID, or 0 if it's not a valid exception
+static int TryCatchInjectionParseExc(
+  char const* const str) {
+
+  // Search the name among the TryCatchExceptions
+  for (
+    int exc = 1;
+    exc < TryCatchExc_LastID;
+    ++exc) {
+
+    if (strcmp(str, exceptionStr[exc]) == 0) return exc;
+
+  }
+
+  // Else convert the value
+  char* end = NULL;
+  long exc = strtol(str, &end, 10);
+  if (*end != '\0' || exc <= 0 || exc > INT_MAX) return 0;
+  return (int)exc;
+
+}
+
+// Function to add one fault injection rule
+// Input:
+//   str: The rule (null terminated)
+// Output:
+//   Return true if the rule is valid, else false
+static bool TryCatchAddInjectionRule(
+  char const* const str) {
+
+  // Split the rule in its site, exception and condition
+  char site[256] = {0};
+  char exc[64] = {0};
+  char cond[64] = {0};
+  int nb =
+    sscanf(
+      str,
+      "%255s %63s %63s",
+      site,
+      exc,
+      cond);
+  if (nb <= 0) return true;
+
+  // Seed of the pseudo random generators
+  uint64_t seed = 0;
+  if (nb == 1 && sscanf(site, "seed=%" SCNu64, &seed) == 1) {
+
+    TryCatchSetInjectionSeed(seed);
+    return true;
+
+  }
+
+  if (nb != 3) return false;
+  int iRule = atomic_load(&nbInjectionRule);
+  if (iRule >= TryCatchMaxNbInjectionRule) return false;
+  struct TryCatchInjectionRule* rule = injectionRules + iRule;
+  *rule = (struct TryCatchInjectionRule){.line = 0};
+
+  // Site, as 'file:line', 'file' or '*'
+  if (strcmp(site, "*") != 0) {
+
+    char* sep = strrchr(site, ':');
+    if (sep != NULL) {
+
+      char* end = NULL;
+      rule->line = (int)strtol(sep + 1, &end, 10);
+      if (*end != '\0' || rule->line <= 0) return false;
+      *sep = '\0';
+
+    }
+
+    strcpy(
+      rule->filename,
+      site);
+
+  }
+
+  // Exception
+  rule->exc = TryCatchInjectionParseExc(exc);
+  if (rule->exc == 0) return false;
+
+  // Condition, as 'p=<probability>' or 'every=<n>'
+  if (
+    sscanf(cond, "p=%lf", &(rule->probability)) != 1 &&
+    (sscanf(cond, "every=%" SCNu64, &(rule->every)) != 1 ||
+    rule->every == 0)) {
+
+    return false;
+
+  }
+
+  // Commit the rule
+  atomic_store(
+    &nbInjectionRule,
+    iRule + 1);
+  atomic_store(
+    &tryCatchInjectionOn,
+    true);
+  return true;
+
+}
+
+// Function to add fault injection rules and turn on the fault injection.
+// Rules are separated by ';' or new lines, and have the syntax
+// '<site> <exception> <condition>' where:
+//        site: 'file:line', 'file' (any line of the file) or '*' (any
+//              site), the file being the end of the file path of the
+//              injection point
+//   exception: name of a TryCatchException (e.g. TryCatchExc_IOError) or
+//              ID of the exception
+//   condition: 'p=<probability>' to raise the exception at random with
+//              the given probability, or 'every=<n>' to raise it every
+//              n-th time the sites of the rule are reached
+// The first rule matching an injection point applies. A rule 'seed=<n>'
+// sets the seed as TryCatchSetInjectionSeed. Text after '#' up to the
+// end of the line is ignored. Rules longer than 511 characters are
+// invalid. Rules should be added before starting other threads.
+// Input:
+//   rules: The rules
+// Output:
+//   Return true if all the rules are valid, else false (valid rules are
+//   added anyway)
+bool TryCatchAddInjectionRules(
+  char const* const rules) {
+
+  // Loop on the rules
+  bool ret = true;
+  char const* ptr = rules;
+  while (*ptr != '\0') {
+
+    // Get the length of the rule, and skip the comment up to the end of
+    // the line if there is one (';' in the comment doesn't start a rule)
+    size_t lenRule = strcspn(ptr, "#;\n");
+    size_t len = lenRule;
+    if (ptr[len] == '#') len += strcspn(ptr + len, "\n");
+
+    // Copy the rule, rejecting it if it is too long instead of truncating
+    // it into another rule
+    char rule[512] = {0};
+    bool isTooLong = (lenRule >= sizeof(rule));
+    if (isTooLong) lenRule = sizeof(rule) - 1;
+    memcpy(
+      rule,
+      ptr,
+      lenRule);
+
+    // Add the rule
+    if (isTooLong || TryCatchAddInjectionRule(rule) == false) {
+
+      fprintf(
+        stderr,
+        "!!! TryCatch: invalid fault injection rule '%s' !!!\n",
+        rule);
+      ret = false;
+
+    }
+
+    ptr += len;
+    if (*ptr != '\0') ++ptr;
+
+  }
+
+  return ret;
+
+}
+
+// Function to turn on the fault injection with the rules given in the
+// environment variable TRYCATCH_INJECT and in the file whose path is
+// given in the environment variable TRYCATCH_INJECT_FILE, if set (see
+// TryCatchAddInjectionRules for the syntax)
+// Output:
+//   Return true if the rules are valid, else false
+bool TryCatchInitInjection(
+  void) {
+
+  bool ret = true;
+
+  // Rules in the environment variable
+  char const* rules = getenv("TRYCATCH_INJECT");
+  if (rules != NULL) ret = TryCatchAddInjectionRules(rules);
+
+  // Rules in the file
+  char const* path = getenv("TRYCATCH_INJECT_FILE");
+  if (path != NULL) {
+
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+
+      fprintf(
+        stderr,
+        "!!! TryCatch: can't open the fault injection file %s !!!\n",
+        path);
+      return false;
+
+    }
+
+    // Loop on the lines, rejecting the ones too long for the buffer
+    // instead of splitting them into several rules
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+
+      if (strchr(line, '\n') == NULL && feof(fp) == 0) {
+
+        fprintf(
+          stderr,
+          "!!! TryCatch: fault injection rule too long in %s !!!\n",
+          path);
+        ret = false;
+        int c = 0;
+        do c = fgetc(fp); while (c != '\n' && c != EOF);
+
+      } else if (TryCatchAddInjectionRules(line) == false) ret = false;
+
+    }
+
+    fclose(fp);
+
+  }
+
+  return ret;
+
+}
+
+// Function to set the seed of the pseudo random generators of the fault
+// injection. Each thread has its own generator, seeded with this seed and
+// its ID, making the injections reproducible for a given seed as long as
+// threads reach the injection points in the same order. The generators
+// of all the threads are seeded again at their next use.
+// Input:
+//   seed: The seed
+void TryCatchSetInjectionSeed(
+  uint64_t const seed) {
+
+  atomic_store_explicit(
+    &injectionSeed,
+    seed,
+    memory_order_relaxed);
+  atomic_fetch_add_explicit(
+    &injectionSeedGen,
+    1,
+    memory_order_release);
+
+}
+
+// Function to turn off the fault injection and remove all its rules
+void TryCatchClearInjection(
+  void) {
+
+  atomic_store(
+    &tryCatchInjectionOn,
+    false);
+  atomic_store(
+    &nbInjectionRule,
+    0);
+
+}
+
+// Function to pop the frame on the top of the stack for a TryCatch block
+// left without reaching its end: a TryRetry or TryBreaker block ends on
+// failure and a TryTransaction block is rolled back. The probe of a
+// circuit breaker left by returning from inside its block has no outcome,
+// it releases its slot and the next block of the breaker becomes the
+// probe.
+// Inputs:
+//           ctx: The context
+//   isAbandoned: True if the block has been left by returning from inside
+//                it, false if it has been skipped by an exception
+static void TryCatchPopFrame(
+  struct TryCatchCtx* const ctx,
+           bool const isAbandoned) {
+
+  --(ctx->lvl);
+  struct TryCatchFrame* frame = ctx->frames + ctx->lvl;
+  frame->inCatch = false;
+  if (frame->retryMax > 0)
+    TryCatchRetryEnd(
+      frame,
+      false);
+  if (frame->breaker != NULL && frame->isProbe && isAbandoned) {
+
+    // The delay of the open circuit has already expired, setting the
+    // circuit open again lets the next block become the probe
+    atomic_store(
+      &(frame->breaker->state),
+      TryCatchBreakerPack(TryCatchBreakerState_Open, 0, 0));
+    frame->breaker = NULL;
+
+  }
+  if (frame->breaker != NULL)
+    TryCatchBreakerEnd(
+      frame,
+      false);
+  if (frame->isTransaction) {
+
+    TryCatchRollback(
+      ctx,
+      frame->undoMark);
+    --(ctx->nbTransaction);
+
+  }
+
+}
+
+// Function to jump back to the current TryCatch block, if any, with the
+// exception 'exc'
+// Inputs:
+//    ctx: The context
+//    exc: The exception
+//   site: The site of the raise (NULL if unknown)
+static void TryCatchJump(
+         struct TryCatchCtx* const ctx,
+                               int exc,
+  struct TryCatchSite const* const site) {
+
+  // Get the time of the raise if the latencies are sampled
+  uint64_t raiseTime =
+    (atomic_load_explicit(
+      &latencyPeriod,
+      memory_order_relaxed) != 0 ? TryCatchGetClockNs() : 0);
+
+  // Record the raise in the flight recorder
+  if (
+    atomic_load_explicit(
+      &flightRecorderOn,
+      memory_order_relaxed))
+    TryCatchFlightRecord(
+      TryCatchFlightKind_Raise,
+      exc,
+      site,
+      ctx->lvl);
+
+  if (ctx->lvl > 0) {
+
+    // Memorise the last raised exception to be able to handle it if
+    // it reaches the default case in the swith statement of the TryCatch
+    // block
+    ctx->exc = exc;
+    ctx->site = site;
+    ctx->siteGen =
+      atomic_load_explicit(
+        &nbSiteForget,
+        memory_order_relaxed);
+
+    // Get the level in the stack where to jump back: the closest level
+    // catching the exception, or the outermost one if none catches it
+    int jumpTo = ctx->lvl - 1;
+    while (jumpTo > 0 && ctx->frames[jumpTo].filter != NULL) {
+
+      int const* filter = ctx->frames[jumpTo].filter;
+      while (*filter != 0 && *filter != exc) ++filter;
+      if (*filter == exc) break;
+      --jumpTo;
+
+    }
+
+    // Pop the skipped levels
+    while (ctx->lvl > jumpTo + 1)
+      TryCatchPopFrame(
+        ctx,
+        false);
+
+    // If the level is a TryRetry block, attempt it again if the exception
+    // is one of the retried ones and there are attempts left, else end it
+    // on failure
+    struct TryCatchFrame* frame = ctx->frames + jumpTo;
+    int val = exc;
+    if (frame->retryMax > 0) {
+
+      int const* filter = frame->filter;
+      while (*filter != 0 && *filter != exc) ++filter;
+      if (
+        frame->inCatch == false &&
+        *filter == exc &&
+        frame->retryAttempt < frame->retryMax) {
+
+        val = TryCatchRetryAgain;
+
+      } else {
+
+        TryCatchRetryEnd(
+          frame,
+          false);
+
+      }
+
+    }
+
+    // If the level is a TryBreaker block, record the failure
+    if (frame->breaker != NULL)
+      TryCatchBreakerEnd(
+        frame,
+        false);
+
+    // If the level is a TryTransaction block, roll back its writes
+    if (frame->isTransaction)
+      TryCatchRollback(
+        ctx,
+        frame->undoMark);
+
+    // If the level is a sampled TryTimed block, memorise the time of the
+    // raise to measure the unwinding when entering the Catch segment
+    if (frame->timedSite != NULL && val != TryCatchRetryAgain)
+      frame->unwindStart = raiseTime;
+
+    // Call longjmp with the appropriate jmp_buf in the stack and the
+    // raised TryCatchException.
+    longjmp(
+      frame->jmp,
+      val);
+
+  }
+
+  // The exception is raised outside of any TryCatch block and execution
+  // continues, dump the events which led to it
+  if (
+    atomic_load_explicit(
+      &flightRecorderOn,
+      memory_order_relaxed)) {
+
+    char const msg[] =
+      "!!! TryCatch: exception raised outside of any TryCatch block !!!\n";
+    TryCatchFlightWrite(
+      msg,
+      sizeof(msg) - 1);
+    if (flightRing != NULL) TryCatchFlightDumpRing(flightRing);
+
+  }
+
+}
+
+// Function called to raise the TryCatchException 'exc'
+// Inputs:
+//    ctx: The context
+//    exc: The TryCatchException to raise. Do not use the type enum
+//         TryCatchException to allow the user to extend the list of
+//         exceptions with user-defined exception outside of enum
+//         TryCatchException.
+//   site: Descriptor of the site where the exception has been raised
+void RaiseCtx_(
+   struct TryCatchCtx* const ctx,
+                         int exc,
+  struct TryCatchSite* const site) {
+
+  // If the stream to record exception raising is set, print the exception
+  // on the stream
+  if (streamRaise != NULL)
+    fprintf(
+      streamRaise,
+      "Exception (%s) raised in %s, line %d.\n",
+      TryCatchExcToStr(exc),
+      site->filename,
+      site->line);
+
+// The binary trace file is based on mmap which is POSIX only, guard
+// against this.
+#if TryCatchPosix
+
+  // If the binary trace file is set, record the exception in it
+  if (atomic_load(&traceMapCur) != NULL)
+    TryCatchTraceRaise(
+      exc,
+      site,
+      ctx->lvl);
+
+#endif
+
+  // Jump back to the current TryCatch block
+  TryCatchJump(
+    ctx,
+    exc,
+    site);
+
+}
+
+// Function called to raise the TryCatchException 'exc'
+// Inputs:
+//    exc: The TryCatchException to raise. Do not use the type enum
+//         TryCatchException to allow the user to extend the list of
+//         exceptions with user-defined exception outside of enum
+//         TryCatchException.
+//   site: Descriptor of the site where the exception has been raised
+void Raise_(
+                        int exc,
+  struct TryCatchSite* const site) {
+
+  RaiseCtx_(
+    TryCatchGetCtx(),
+    exc,
+    site);
+
+}
+
+// Function to raise the TryCatchException 'exc' from a signal handler.
+// Unlike Raise, it is async-signal-safe: the exception is neither printed
+// on the raise stream nor recorded in the binary trace (whose writers may
+// be the interrupted code), and the context is not created if the thread
+// has none. The site of the exception is unknown.
+// Input:
+//   exc: The TryCatchException to raise
+// Output:
+//   Doesn't return if the current thread is in a TryCatch block, else
+//   return false
+bool TryCatchRaiseFromSignal(
+  int const exc) {
+
+  // Don't create the context here, if there is none there is no block
+  struct TryCatchCtx* ctx = tryCatchCtx;
+  if (ctx == NULL || ctx->lvl == 0) return false;
+  TryCatchJump(
+    ctx,
+    exc,
+    NULL);
+  return false;
+
+}
+
+// Function to add a handler of a resumable exception. The handlers are
+// called without unwinding, the last added first, until one supplies the
+// value. The handlers belong to the context of the current thread: they
+// handle the exceptions raised by this thread only, and follow the
+// context if it's attached to another thread.
+// Inputs:
+//   exc: The exception
+//   fun: The handler
+// Output:
+//   Return true if the handler could be added, false if there are already
+//   TryCatchMaxNbResumeFun handlers or the memory couldn't be allocated
+bool TryCatchAddResumeFun(
+                int const exc,
+  TryCatchResumeFun const fun) {
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  if (ctx->nbResumeHandler >= TryCatchMaxNbResumeFun) return false;
+  if (ctx->resumeHandlers == NULL) {
+
+    ctx->resumeHandlers =
+      malloc(
+        TryCatchMaxNbResumeFun * sizeof(struct TryCatchResumeHandler));
+    if (ctx->resumeHandlers == NULL) return false;
+
+  }
+
+  ctx->resumeHandlers[ctx->nbResumeHandler] =
+    (struct TryCatchResumeHandler){.exc = exc, .fun = fun};
+  ++(ctx->nbResumeHandler);
+  return true;
+
+}
+
+// Function to remove a handler of a resumable exception from the context
+// of the current thread
+// Inputs:
+//   exc: The exception
+//   fun: The handler
+void TryCatchRemoveResumeFun(
+                int const exc,
+  TryCatchResumeFun const fun) {
+
+  // Remove the last addition of the handler, keeping the order of the
+  // other ones
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  struct TryCatchResumeHandler* handlers = ctx->resumeHandlers;
+  for (
+    int iHandler = ctx->nbResumeHandler - 1;
+    iHandler >= 0;
+    --iHandler) {
+
+    if (
+      handlers[iHandler].exc == exc &&
+      handlers[iHandler].fun == fun) {
+
+      memmove(
+        handlers + iHandler,
+        handlers + iHandler + 1,
+        (size_t)(ctx->nbResumeHandler - iHandler - 1) *
+          sizeof(struct TryCatchResumeHandler));
+      --(ctx->nbResumeHandler);
+      return;
+
+    }
+
+  }
+
+}
+
+// Function called to raise the resumable TryCatchException 'exc'. The
+// handlers of the exception are called first and can supply a
+// replacement value, in which case the function returns and the execution
+// continues at the raise site. If they all decline, the exception is
+// raised as with Raise_.
+// Inputs:
+//     exc: The TryCatchException to raise
+//   value: The value to be replaced by the handlers
+//    site: Descriptor of the site where the exception has been raised
+void RaiseResumable_(
+                        int exc,
+                      void* value,
+  struct TryCatchSite* const site) {
+
+  // Give the exception to the handlers of the context, the last added
+  // first, until one supplies the value. No TryCatch block is entered or
+  // left, so the resumption costs only the calls to the handlers. The
+  // handlers are read again at each step as they may add or remove
+  // handlers themselves.
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  for (
+    int iHandler = ctx->nbResumeHandler - 1;
+    iHandler >= 0;
+    --iHandler) {
+
+    if (iHandler >= ctx->nbResumeHandler) continue;
+    struct TryCatchResumeHandler handler = ctx->resumeHandlers[iHandler];
+    if (
+      handler.exc == exc &&
+      (*(handler.fun))(
+        exc,
+        value,
+        site)) {
+
+      if (
+        atomic_load_explicit(
+          &flightRecorderOn,
+          memory_order_relaxed))
+        TryCatchFlightRecord(
+          TryCatchFlightKind_Resume,
+          exc,
+          site,
+          ctx->lvl);
+      return;
+
+    }
+
+  }
+
+  // No handler has supplied the value, unwind as with Raise
+  RaiseCtx_(
+    ctx,
+    exc,
+    site);
+
+}
+
+// pthread_kill is POSIX only, guard against this.
+#if TryCatchPosix
+
+// Signal sent by TryCatchCancel to interrupt the blocking system calls of
+// the cancelled thread, 0 if none
+static _Atomic int cancelSignal = 0;
+
+// Handler of the signal interrupting the cancelled thread, doing nothing:
+// the interrupted system call fails with EINTR and the cancellation is
+// raised at the next checkpoint
+// Input:
+//   signal: Received signal
+static void TryCatchCancelSigHandler(
+  int signal) {
+
+  (void)signal;
+
+}
+
+// Function to set the signal sent by TryCatchCancel to the thread of the
+// cancelled context, interrupting its blocking system calls (which fail
+// with EINTR) so it reaches its next checkpoint without delay
+// Input:
+//   signum: The signal (for example SIGUSR2), 0 to send no signal
+// Output:
+//   Return true if the handler of the signal could be set, else false
+bool TryCatchInitCancelSignal(
+  int const signum) {
+
+  // Set the handler, without SA_RESTART to interrupt the system calls
+  if (signum != 0) {
+
+    struct sigaction sigAction;
+    memset(
+      &sigAction,
+      0,
+      sizeof(struct sigaction));
+    sigemptyset(&(sigAction.sa_mask));
+    sigAction.sa_handler = TryCatchCancelSigHandler;
+    sigAction.sa_flags = 0;
+    if (
+      sigaction(
+        signum,
+        &sigAction,
+        NULL) != 0) {
+
+      return false;
+
+    }
+
+  }
+
+  atomic_store(
+    &cancelSignal,
+    signum);
+  return true;
+
+}
+
+#endif
+
+// Function to request the cancellation of a context, usually the one of
+// another thread: TryCatchExc_Cancelled will be raised at the next
+// checkpoint reached while the context is attached. The context must stay
+// valid during the call.
+// Input:
+//   ctx: The context
+void TryCatchCancel(
+  struct TryCatchCtx* const ctx) {
+
+  atomic_store(
+    &(ctx->isCancelPending),
+    true);
+
+// pthread_kill is POSIX only, guard against this.
+#if TryCatchPosix
+
+  // Interrupt the thread if requested
+  int signum = atomic_load(&cancelSignal);
+  if (signum != 0 && atomic_load(&(ctx->isAttached)))
+    pthread_kill(
+      ctx->thread,
+      signum);
+
+#endif
+
+}
+
+// Function to raise TryCatchExc_Cancelled if the cancellation of the
+// current context has been requested, clearing the request
+// Input:
+//   site: Descriptor of the site of the checkpoint, where the exception is
+//         raised
+void TryCatchCheckpoint_(
+  struct TryCatchSite* const site) {
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  if (
+    atomic_load_explicit(
+      &(ctx->isCancelPending),
+      memory_order_relaxed) &&
+    atomic_exchange(
+      &(ctx->isCancelPending),
+      false)) {
+
+    RaiseCtx_(
+      ctx,
+      TryCatchExc_Cancelled,
+      site);
+
+  }
+
+}
+
+// Function to check if the cancellation of the current context has been
+// requested, without clearing the request. Used by the code waiting in
+// blocking system calls to stop waiting when they fail with EINTR.
+// Output:
+//   Return true if the cancellation is pending, else false
+bool TryCatchIsCancelPending(
+  void) {
+
+  return
+    atomic_load_explicit(
+      &(TryCatchGetCtx()->isCancelPending),
+      memory_order_relaxed);
+
+}
+
+// Function to clear the request of cancellation of a context, if any.
+// Used to reuse the context of a thread for a new task without it being
+// cancelled by a request targeting the previous one.
+// Input:
+//   ctx: The context
+void TryCatchCtxClearCancel(
+  struct TryCatchCtx* const ctx) {
+
+  atomic_store(
+    &(ctx->isCancelPending),
+    false);
+
+}
+
+// Function to get the value of a TryCatchResult, raising its exception
+// from its site if it's a failure
+// Input:
+//   res: The result
+// Output:
+//   Return the value of the result
+union TryCatchValue TryCatchUnwrap(
+  struct TryCatchResult const res) {
+
+  // Raise the failure as if it was raised from its site
+  if (res.exc != 0)
+    Raise_(
+      res.exc,
+      res.site);
+
+  // Return the value
+  return res.val;
+
+}
+
+// Function called when entering a catch block
+// Input:
+//   ctx: The context
+void TryCatchCtxEnterCatchBlock(
+  struct TryCatchCtx* const ctx) {
+
+  // Update the flag
+  struct TryCatchFrame* frame = ctx->frames + ctx->lvl - 1;
+  frame->inCatch = true;
+
+  // Record the duration of the unwinding if the block is a sampled
+  // TryTimed block
+  if (frame->unwindStart != 0) {
+
+    TryCatchLatencyRecord(
+      frame->timedSite,
+      TryCatchLatencyKind_Unwind,
+      TryCatchGetClockNs() - frame->unwindStart);
+    frame->unwindStart = 0;
+
+  }
+
+  // Record the entrance in the catch block in the flight recorder
+  if (
+    atomic_load_explicit(
+      &flightRecorderOn,
+      memory_order_relaxed))
+    TryCatchFlightRecord(
+      TryCatchFlightKind_Catch,
+      ctx->exc,
+      NULL,
+      ctx->lvl);
+
+}
+
+// Function called when entering a catch block
+void TryCatchEnterCatchBlock(
+  void) {
+
+  TryCatchCtxEnterCatchBlock(TryCatchGetCtx());
+
+}
+
+// Function called when exiting a catch block
+// Input:
+//   ctx: The context
+void TryCatchCtxExitCatchBlock(
+  struct TryCatchCtx* const ctx) {
+
+  // Update the flag, if the block hasn't been popped already (for
+  // example by TryCatchRestoreLevel)
+  if (ctx->lvl > 0) ctx->frames[ctx->lvl - 1].inCatch = false;
+
+}
+
+// Function called when exiting a catch block
+void TryCatchExitCatchBlock(
+  void) {
+
+  TryCatchCtxExitCatchBlock(TryCatchGetCtx());
+
+}
+
+// Function called at the end of a TryCatch block
+// Input:
+//   ctx: The context
+void TryCatchCtxEnd(
+  struct TryCatchCtx* const ctx) {
+
+  // The execution has reached the end of the current TryCatch block,
+  // move back to the lower level in the stack of frames, a TryRetry or
+  // TryBreaker block still running ends on success
+  if (ctx->lvl > 0) {
+
+    ctx->lvl--;
+    if (ctx->frames[ctx->lvl].retryMax > 0)
+      TryCatchRetryEnd(
+        ctx->frames + ctx->lvl,
+        true);
+    if (ctx->frames[ctx->lvl].breaker != NULL)
+      TryCatchBreakerEnd(
+        ctx->frames + ctx->lvl,
+        true);
+
+    // Record the duration of a sampled TryTimed block
+    if (ctx->frames[ctx->lvl].timedSite != NULL)
+      TryCatchLatencyRecord(
+        ctx->frames[ctx->lvl].timedSite,
+        TryCatchLatencyKind_Block,
+        TryCatchGetClockNs() - ctx->frames[ctx->lvl].timedStart);
+
+    // At the end of a TryTransaction block, its log is merged in the log
+    // of the enclosing transaction if any, else discarded
+    if (ctx->frames[ctx->lvl].isTransaction) {
+
+      --(ctx->nbTransaction);
+      if (ctx->nbTransaction == 0) ctx->undoSize = 0;
+
+    }
+
+  }
+
+  // Record the exit of the block in the flight recorder
+  if (
+    atomic_load_explicit(
+      &flightRecorderOn,
+      memory_order_relaxed))
+    TryCatchFlightRecord(
+      TryCatchFlightKind_Exit,
+      0,
+      NULL,
+      ctx->lvl);
+
+}
+
+// Function called at the end of a TryCatch block
+void TryCatchEnd(
+  void) {
+
+  TryCatchCtxEnd(TryCatchGetCtx());
+
+}
+
+// Function to apply a function to each element of an array, isolating
+// the failure of each element (see TryCatchEach)
+// Inputs:
+//        ctx: The context
+//      array: The array
+//     nbElem: The number of elements in the array
+//   sizeElem: The size in bytes of one element
+//        fun: The function applied to the elements
+//   failures: Where to store the list of failures
+//       site: Descriptor of the site of the call
+// Output:
+//   Return the number of failures
+static size_t TryCatchCtxEach(
+           struct TryCatchCtx* const ctx,
+                         void* const array,
+                        size_t const nbElem,
+                        size_t const sizeElem,
+               TryCatchEachFun const fun,
+  struct TryCatchEachFailure** const failures,
+           struct TryCatchSite* const site) {
+
+  // Variables modified after the setjmp are volatile
+  volatile size_t iElem = 0;
+  volatile size_t nbFailure = 0;
+  volatile size_t capacity = 0;
+  struct TryCatchEachFailure* volatile list = NULL;
+  volatile bool isMallocFailed = false;
+
+  // Enter the TryCatch block, the exceptions raised by the elements jump
+  // back here, the jmp_buf stays valid for all the elements
+  TryCatchCtxGuardOverflow(ctx);
+  jmp_buf* jmp = TryCatchCtxGetJmpBufOnStackTop(ctx);
+  if (setjmp(*jmp) != 0) {
+
+    // Add the failure to the list if it's needed
+    if (failures != NULL) {
+
+      if (nbFailure == capacity) {
+
+        size_t newCapacity = (capacity == 0 ? 16 : capacity * 2);
+        struct TryCatchEachFailure* ptr =
+          realloc(
+            list,
+            newCapacity * sizeof(struct TryCatchEachFailure));
+        if (ptr == NULL) {
+
+          isMallocFailed = true;
+          iElem = nbElem;
+
+        } else {
+
+          list = ptr;
+          capacity = newCapacity;
+
+        }
+
+      }
+
+      if (isMallocFailed == false)
+        list[nbFailure] = (struct TryCatchEachFailure){
+          .index = iElem,
+          .exc = ctx->exc
+        };
+
+    }
+
+    if (isMallocFailed == false) {
+
+      ++nbFailure;
+      ++iElem;
+
+    }
+
+  }
+
+  // Process the remaining elements
+  while (iElem < nbElem) {
+
+    fun((char*)array + iElem * sizeElem);
+    ++iElem;
+
+  }
+
+  // Exit the TryCatch block
+  TryCatchCtxEnd(ctx);
+  if (isMallocFailed) {
+
+    free(list);
+    RaiseCtx_(
+      ctx,
+      TryCatchExc_MallocFailed,
+      site);
+
+  }
+
+  // Return the failures
+  if (failures != NULL) *failures = list;
+  return nbFailure;
+
+}
+
+// Function to apply a function to each element of an array, isolating
+// the failure of each element: if an exception is raised while
+// processing an element, its index and the exception are added to the
+// list of failures and the processing resumes at the next element. Only
+// one TryCatch block is entered for the whole array, the cost of the
+// isolation is paid only by the failing elements.
+// Inputs:
+//      array: The array
+//     nbElem: The number of elements in the array
+//   sizeElem: The size in bytes of one element
+//        fun: The function applied to the elements
+//   failures: Where to store the list of failures in order of index,
+//             allocated with malloc and to be freed by the user, NULL if
+//             there is no failure (can be NULL if the list is not needed)
+//       site: Descriptor of the site of the call, where
+//             TryCatchExc_MallocFailed is raised
+// Output:
+//   Return the number of failures. TryCatchExc_MallocFailed is raised if
+//   the list of failures couldn't be allocated.
+size_t TryCatchEach_(
+                         void* const array,
+                        size_t const nbElem,
+                        size_t const sizeElem,
+               TryCatchEachFun const fun,
+  struct TryCatchEachFailure** const failures,
+           struct TryCatchSite* const site) {
+
+  // Run the loop in its own function to keep the context out of the
+  // variables clobbered by longjmp
+  return
+    TryCatchCtxEach(
+      TryCatchGetCtx(),
+      array,
+      nbElem,
+      sizeElem,
+      fun,
+      failures,
+      site);
+
+}
+
+// The struct siginfo_t used to handle the SIGSEV is POSIX only, guard
+// against this.
+#if TryCatchPosix
+
+// Handler function to raise the exception TryCatchExc_Segv when
+// receiving the signal SIGSEV, or TryCatchExc_IOError when receiving the
+// signal SIGBUS (access to a truncated mapped file).
+// Inputs:
+//   signal: Received signal, SIGSEV or SIGBUS
+//       si: Info about the signal, unused
+//      arg: Optional arguments, unused
+void TryCatchSigSegvHandler(
+         int signal,
+  siginfo_t* si,
+       void* arg) {
+
+  // Unused parameters
+  (void)si; (void)arg;
+
+  // If there is no TryCatch block to jump back to, the fault can't be
+  // recovered, restore the default handler to let the process end when
+  // the faulty code is executed again after returning from the handler
+  // (Don't create the context here, if there is none there is no block)
+  struct TryCatchCtx* ctx = tryCatchCtx;
+  if (ctx == NULL || ctx->lvl == 0) {
+
+    if (
+      atomic_load_explicit(
+        &flightRecorderOn,
+        memory_order_relaxed)) {
+
+      char const msg[] =
+        "!!! TryCatch: segmentation fault outside of any TryCatch "
+        "block !!!\n";
+      TryCatchFlightWrite(
+        msg,
+        sizeof(msg) - 1);
+      TryCatchDumpFlightRecorder();
+
+    }
+
+    struct sigaction sigActionDefault;
+    memset(
+      &sigActionDefault,
+      0,
+      sizeof(struct sigaction));
+    sigemptyset(&(sigActionDefault.sa_mask));
+    sigActionDefault.sa_handler = SIG_DFL;
+    sigaction(
+      signal,
+      &sigActionDefault,
+      NULL);
+    return;
+
+  }
+
+  // Raise the exception (without trace, the site of the raise is the
+  // handler, not the faulty code)
+  TryCatchJump(
+    ctx,
+    (signal == SIGBUS ? TryCatchExc_IOError : TryCatchExc_Segv),
+    NULL);
+
+}
+
+// Function to set TryCatchSigSegvHandler as the handler of a signal
+// Input:
+//   signum: The signal
+static void TryCatchSetFaultHandler(
+  int const signum) {
+
+  // Create a struct sigaction to set the handler
+  struct sigaction sigActionSegv;
+  memset(
+    &sigActionSegv,
+    0,
+    sizeof(struct sigaction));
+  sigemptyset(&(sigActionSegv.sa_mask));
+  sigActionSegv.sa_sigaction = TryCatchSigSegvHandler;
+
+  // SA_NODEFER: the handler leaves with longjmp, the signal must not stay
+  // blocked afterward for the next faults to be caught too
+  sigActionSegv.sa_flags = SA_SIGINFO | SA_NODEFER;
+
+  // Set the handler
+  sigaction(
+    signum,
+    &sigActionSegv,
+    NULL);
+
+}
+
+// Function to set the handler function of the signal SIGSEV and raise
+// TryCatchExc_Segv upon reception of this signal. Must have been
+// called before using Catch(TryCatchExc_Segv)
+void TryCatchInitHandlerSigSegv(
+  void) {
+
+  TryCatchSetFaultHandler(SIGSEGV);
+
+}
+
+// Function to set the handler function of the signal SIGBUS and raise
+// TryCatchExc_IOError upon reception of this signal (access beyond the
+// end of a mapped file). The handler is process wide and replaces any
+// handler previously set for SIGBUS.
+void TryCatchInitHandlerSigBus(
+  void) {
+
+  TryCatchSetFaultHandler(SIGBUS);
+
+}
+
+// Function to copy memory inside a TryCatch block, raising again from the
+// site of the probe the exception raised by the handlers of SIGSEGV and
+// SIGBUS if the copy faults
+// Inputs:
+//    dst: The destination
+//    src: The source
+//    len: The number of bytes to copy
+//   site: Descriptor of the site of the probe
+static void TryCatchProbeCopy(
+                void* const dst,
+          void const* const src,
+               size_t const len,
+  struct TryCatchSite* const site) {
+
+  // Copy with memcpy, which uses the vectorised copy of the C library:
+  // the cost of the probe is the one of the copy plus one setjmp. The
+  // exception is memorised in a volatile as it is modified after the
+  // setjmp.
+  volatile int exc = 0;
+  Try {
+
+    memcpy(
+      dst,
+      src,
+      len);
+
+  } CatchDefault {
+
+    exc = TryCatchGetLastExc();
+
+  } EndCatch;
+  if (exc != 0)
+    Raise_(
+      exc,
+      site);
+
+}
+
+// Function to copy memory from a location which may be invalid, like a
+// pointer given by an untrusted plugin or a mapped file which may have
+// been truncated. TryCatchExc_Segv is raised if the source is not
+// readable, TryCatchExc_IOError if it is beyond the end of a mapped file.
+// The handlers of the signals must have been set with
+// TryCatchInitHandlerSigSegv and TryCatchInitHandlerSigBus, else a fault
+// ends the process as without probe.
+// Inputs:
+//    dst: The destination
+//    src: The probed source
+//    len: The number of bytes to copy
+//   site: Descriptor of the site of the probe
+void TryCatchProbeRead_(
+                void* const dst,
+          void const* const src,
+               size_t const len,
+  struct TryCatchSite* const site) {
+
+  TryCatchProbeCopy(
+    dst,
+    src,
+    len,
+    site);
+
+}
+
+// Function to copy memory to a location which may be invalid, like a
+// pointer given by an untrusted plugin or a mapped file which may have
+// been truncated. TryCatchExc_Segv is raised if the destination is not
+// writable, TryCatchExc_IOError if it is beyond the end of a mapped file.
+// The handlers of the signals must have been set with
+// TryCatchInitHandlerSigSegv and TryCatchInitHandlerSigBus, else a fault
+// ends the process as without probe.
+// Inputs:
+//    dst: The probed destination
+//    src: The source
+//    len: The number of bytes to copy
+//   site: Descriptor of the site of the probe
+void TryCatchProbeWrite_(
+                void* const dst,
+          void const* const src,
+               size_t const len,
+  struct TryCatchSite* const site) {
+
+  TryCatchProbeCopy(
+    dst,
+    src,
+    len,
+    site);
+
+}
+
+// Handler function to dump the flight recorder when receiving a fatal
+// signal.
+// Input:
+//   signal: Received signal
+static void TryCatchFlightSigHandler(
+  int signal) {
+
+  char const msg[] = "!!! TryCatch: fatal signal received !!!\n";
+  TryCatchFlightWrite(
+    msg,
+    sizeof(msg) - 1);
+  TryCatchDumpFlightRecorder();
+
+  // The default handler has been restored upon entrance in this one
+  // (SA_RESETHAND), raise the signal again to end the process (for faults
+  // the faulty code will also be executed again after returning)
+  raise(signal);
+
+}
+
+#endif
+
+// Function to turn on the flight recorder. The last events (entrance and
+// exit of TryCatch blocks, raise, catch) of each thread are kept in memory
+// and dumped on the standard error output when an exception is raised
+// outside of any TryCatch block, and (POSIX feature) when the process
+// receives a fatal signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT) which
+// has no handler.
+void TryCatchInitFlightRecorder(
+  void) {
+
+  // Create the key used to release the rings of exiting threads
+  call_once(
+    &flightRingKeyOnce,
+    TryCatchFlightCreateKey);
+
+  // Turn on the recording
+  atomic_store(
+    &flightRecorderOn,
+    true);
+
+// The struct sigaction used to handle the signals is POSIX only, guard
+// against this.
+#if TryCatchPosix
+
+  // Loop on the fatal signals
+  int const fatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+  for (
+    size_t iSignal = 0;
+    iSignal < sizeof(fatalSignals) / sizeof(fatalSignals[0]);
+    ++iSignal) {
+
+    // Set the handler if the signal has none (keep the one set by
+    // TryCatchInitHandlerSigSegv or by the user)
+    struct sigaction sigAction;
+    sigaction(
+      fatalSignals[iSignal],
+      NULL,
+      &sigAction);
+    if (
+      (sigAction.sa_flags & SA_SIGINFO) == 0 &&
+      sigAction.sa_handler == SIG_DFL) {
+
+      memset(
+        &sigAction,
+        0,
+        sizeof(struct sigaction));
+      sigemptyset(&(sigAction.sa_mask));
+      sigAction.sa_handler = TryCatchFlightSigHandler;
+      sigAction.sa_flags = SA_RESETHAND;
+      sigaction(
+        fatalSignals[iSignal],
+        &sigAction,
+        NULL);
+
+    }
+
+  }
+
+#endif
+
+}
+
+// Function to get the ID of the last raised exception
+// Output:
+//   Return the id of the last raised exception
+int TryCatchGetLastExc(
+  void) {
+
+  // Return the ID
+  return TryCatchGetCtx()->exc;
+
+}
+
+// Function to get the number of TryCatch blocks currently running in the
+// current thread
+// Output:
+//   Return the level in the stack of TryCatch blocks
+int TryCatchGetLevel(
+  void) {
+
+  return TryCatchGetCtx()->lvl;
+
+}
+
+// Function to end the TryCatch blocks above a level in the stack of the
+// current thread, left open by code returning from inside them without
+// reaching their EndCatch. They end as if skipped by an exception, except
+// the probe of a circuit breaker which releases its slot to the next block
+// of the breaker. Does nothing if the level is not below the current one.
+// Input:
+//   lvl: The level to restore, as returned by TryCatchGetLevel
+void TryCatchRestoreLevel(
+  int const lvl) {
+
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  while (ctx->lvl > lvl && ctx->lvl > 0)
+    TryCatchPopFrame(
+      ctx,
+      true);
+
+}
+
+// Function to get the site of the last raised exception
+// Output:
+//   Return the site, or NULL if it's unknown (for example for exceptions
+//   raised by the handler of SIGSEGV, or sites forgotten since by
+//   TryCatchForgetSites)
+struct TryCatchSite const* TryCatchGetLastSite(
+  void) {
+
+  // Return the site, unless its memory may have been unmapped since
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  return
+    TryCatchResolveSite(
+      ctx->site,
+      ctx->siteGen);
+
+}
+
+// Function to get the ID of the last raised exception
+// Input:
+//   ctx: The context
+// Output:
+//   Return the id of the last raised exception
+int TryCatchCtxGetLastExc(
+  struct TryCatchCtx const* const ctx) {
 
   // Return the ID
-  return tryCatchExc;
+  return ctx->exc;
 
 }
 
@@ -324,8 +4269,12 @@ void TryCatchAddExcToStrFun(
 
   // If the buffer of pointer to conversion function is full, raise
   // the exception TooManyExcToStrFun
+  // (without trace, as it is an error of the library usage)
   if (nbUserDefinedExcToStr >= nbMaxUserDefinedExcToStr)
-    Raise(TryCatchExc_TooManyExcToStrFun);
+    TryCatchJump(
+      TryCatchGetCtx(),
+      TryCatchExc_TooManyExcToStrFun,
+      NULL);
 
   // Loop on the pointer to conversion functions
   for (
@@ -382,7 +4331,13 @@ void ForwardExc(
   void) {
 
   // If there is a currently raised exception, reraise it
-  if (tryCatchExc != 0) Raise(tryCatchExc);
+  // (without trace, to avoid unnecessary repetition in the trace)
+  struct TryCatchCtx* ctx = TryCatchGetCtx();
+  if (ctx->exc != 0)
+    TryCatchJump(
+      ctx,
+      ctx->exc,
+      NULL);
 
 }
 
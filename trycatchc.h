@@ -11,6 +11,20 @@
 #include <setjmp.h>
 #include <signal.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Flag to memorise if the platform is POSIX. The features relying on
+// POSIX (signals, mmap, pthread, clock_gettime) are then built whatever
+// the C standard used for compilation, else they are left out. Can be set
+// to 0 at compilation to build only the ANSI C features.
+#ifndef TryCatchPosix
+#if defined(__unix__) || defined(__APPLE__)
+#define TryCatchPosix 1
+#else
+#define TryCatchPosix 0
+#endif
+#endif
 
 // List of exceptions ID, must starts at 1 (0 is reserved for the setjmp at
 // the beginning of the TryCatch blocks). One can extend the list at will
@@ -26,6 +40,10 @@
 // TryCatchExc_LastID is not an exception but a convenience to
 // create new exceptions (as in the example above) while ensuring
 // their ID doesn't collide with the ID of exceptions in TryCatchException.
+// The exceptions added to the library are inserted before
+// TryCatchExc_LastID, hence the IDs of the user-defined exceptions change
+// from one version of the library to another: they must not be persisted
+// or exchanged between programs built with different versions.
 // Exception defined here are only examples, one should create a list of
 // default exceptions according to the planned use of this trycatch module.
 enum TryCatchException {
@@ -40,15 +58,130 @@ enum TryCatchException {
   TryCatchExc_NotYetImplemented,
   TryCatchExc_UnitTestFailed,
   TryCatchExc_InfiniteLoop,
+  TryCatchExc_SandboxCrashed,
+  TryCatchExc_CircuitOpen,
+  TryCatchExc_Cancelled,
   TryCatchExc_LastID
 
 };
 
+// Context of execution of TryCatch blocks (stack of blocks, last raised
+// exception). Each thread has its own context, used implicitly by Try,
+// Catch, Raise, etc. The macros and functions with the 'Ctx' suffix take
+// the context as an explicit argument instead, saving its lookup in the
+// thread local storage. Hot code can get the context once with
+// TryCatchGetCtx() and pass it down. Both can be mixed as long as the
+// context given explicitly is the one of the current thread.
+struct TryCatchCtx;
+
+// Descriptor of a raise site, defined with Raise
+struct TryCatchSite;
+
+// Function to get the context of TryCatch blocks of the current thread, to
+// be used with the ...Ctx functions and macros
+// Output:
+//   Return the context
+struct TryCatchCtx* TryCatchGetCtx(
+  void);
+
+// Function to create a context, for example for a fiber, independent of
+// the context of the thread. It can be attached to any thread with
+// TryCatchCtxAttach, one thread at a time.
+// Input:
+//   maxLvl: The maximum number of nested TryCatch blocks in the context
+// Output:
+//   Return the context, or NULL if it couldn't be allocated
+struct TryCatchCtx* TryCatchCtxCreate(
+  int const maxLvl);
+
+// Function to free a context created with TryCatchCtxCreate. It must not
+// be attached to a thread.
+// Input:
+//   ctx: The context, set to NULL on return
+void TryCatchCtxFree(
+  struct TryCatchCtx** const ctx);
+
+// Function to attach a context to the current thread, replacing the one
+// currently attached. Used by fiber schedulers, the switch is a swap of
+// pointer: the context of the fiber being suspended is detached and the
+// one of the fiber being resumed is attached.
+// Input:
+//   ctx: The context to attach, or NULL to attach back the thread's own
+//        context
+// Output:
+//   Return the context previously attached (never NULL)
+struct TryCatchCtx* TryCatchCtxAttach(
+  struct TryCatchCtx* const ctx);
+
+// Function to request the cancellation of a context, usually the one of
+// another thread: TryCatchExc_Cancelled will be raised at the next
+// checkpoint reached while the context is attached. The context must stay
+// valid during the call.
+// Input:
+//   ctx: The context
+void TryCatchCancel(
+  struct TryCatchCtx* const ctx);
+
+// Function to raise TryCatchExc_Cancelled if the cancellation of the
+// current context has been requested, clearing the request
+// Input:
+//   site: Descriptor of the site of the checkpoint, where the exception is
+//         raised
+void TryCatchCheckpoint_(
+  struct TryCatchSite* const site);
+
+// Wrapper to call TryCatchCheckpoint_ with the descriptor of the site of
+// the checkpoint. To be called at the safe points of long running code.
+#define TryCatchCheckpoint()                              \
+  do {                                                    \
+    static struct TryCatchSite tryCatchCheckpointSite = { \
+      __FILE__, __LINE__, __func__, 0};                   \
+    TryCatchCheckpoint_(&tryCatchCheckpointSite);         \
+  } while (false)
+
+// Function to check if the cancellation of the current context has been
+// requested, without clearing the request. Used by the code waiting in
+// blocking system calls to stop waiting when they fail with EINTR.
+// Output:
+//   Return true if the cancellation is pending, else false
+bool TryCatchIsCancelPending(
+  void);
+
+// Function to clear the request of cancellation of a context, if any.
+// Used to reuse the context of a thread for a new task without it being
+// cancelled by a request targeting the previous one.
+// Input:
+//   ctx: The context
+void TryCatchCtxClearCancel(
+  struct TryCatchCtx* const ctx);
+
+// pthread_kill is POSIX only, guard against this.
+#if TryCatchPosix
+
+// Function to set the signal sent by TryCatchCancel to the thread of the
+// cancelled context, interrupting its blocking system calls (which fail
+// with EINTR) so it reaches its next checkpoint without delay
+// Input:
+//   signum: The signal (for example SIGUSR2), 0 to send no signal
+// Output:
+//   Return true if the handler of the signal could be set, else false
+bool TryCatchInitCancelSignal(
+  int const signum);
+
+#endif
+
 // Function called at the beginning of a TryCatch block to guard against
 // overflow of the stack of jump_buf
 void TryCatchGuardOverflow(
   void);
 
+// Function called at the beginning of a TryCatch block to guard against
+// overflow of the stack of jump_buf
+// Input:
+//   ctx: The context
+void TryCatchCtxGuardOverflow(
+  struct TryCatchCtx* const ctx);
+
 // Function called to get the jmp_buf on the top of the stack when
 // starting a new TryCatch block
 // Output:
@@ -56,18 +189,53 @@ void TryCatchGuardOverflow(
 jmp_buf* TryCatchGetJmpBufOnStackTop(
   void);
 
+// Function called to get the jmp_buf on the top of the stack when
+// starting a new TryCatch block
+// Input:
+//   ctx: The context
+// Output:
+//   Remove the jmp_buf on the top of the stack and return it
+jmp_buf* TryCatchCtxGetJmpBufOnStackTop(
+  struct TryCatchCtx* const ctx);
+
+// Function called at the beginning of a TryFor block to register the
+// exceptions caught by the block
+// Input:
+//   excs: The list of caught exceptions, terminated by 0. The list must
+//         stay valid until the end of the block.
+void TryCatchSetNextFilter(
+  int const* const excs);
+
 // Function called when entering a catch block
 void TryCatchEnterCatchBlock(
   void);
 
+// Function called when entering a catch block
+// Input:
+//   ctx: The context
+void TryCatchCtxEnterCatchBlock(
+  struct TryCatchCtx* const ctx);
+
 // Function called when exiting a catch block
 void TryCatchExitCatchBlock(
   void);
 
+// Function called when exiting a catch block
+// Input:
+//   ctx: The context
+void TryCatchCtxExitCatchBlock(
+  struct TryCatchCtx* const ctx);
+
 // Function called at the end of a TryCatch block
 void TryCatchEnd(
   void);
 
+// Function called at the end of a TryCatch block
+// Input:
+//   ctx: The context
+void TryCatchCtxEnd(
+  struct TryCatchCtx* const ctx);
+
 // Head of the TryCatch block, to be used as
 //
 // Try {
@@ -85,6 +253,331 @@ void TryCatchEnd(
   switch (setjmp(*TryCatchGetJmpBufOnStackTop())) { \
     case 0:
 
+// Head of a TryCatch block catching only the exceptions given in argument,
+// to be used as
+//
+// TryFor (/*... one or several exceptions ...*/) {
+//   /*... code of the TryCatch block here ...*/
+//
+// Other exceptions raised in the block skip it and jump directly to the
+// closest enclosing block catching them (a block opened with Try is
+// considered as catching all exceptions), as if they had been forwarded
+// with ForwardExc, but with a single longjmp. If no enclosing block
+// catches them they end in the outermost block. The exceptions of the list
+// should be the ones in the Catch and CatchAlso segments of the block,
+// there is no need to use CatchDefault.
+//
+// Comments on the macro:
+//   // Guard against recursive incursion overflow
+//   TryCatchGuardOverflow();
+//   // Register the list of caught exceptions, terminated by 0
+//   TryCatchSetNextFilter((int const[]){__VA_ARGS__, 0});
+//   // Memorise the jmp_buf on the top of the stack, setjmp returns 0
+//   switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {
+//     // Entry point for the code of the TryCatch block
+//     case 0:
+#define TryFor(...)                                     \
+  TryCatchGuardOverflow();                              \
+  TryCatchSetNextFilter((int const[]){__VA_ARGS__, 0}); \
+  switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {     \
+    case 0:
+
+// Value returned by setjmp when a TryRetry block is attempted again
+#define TryCatchRetryAgain (-1)
+
+// Backoff policy of TryRetry blocks, and statistics of the blocks using
+// it. The delay before the n-th retry is
+// delay * factor^(n-1), limited to maxDelay, from which a random fraction
+// in [0, jitter] is removed to spread the retries of concurrent threads.
+// To be declared as, for example,
+//
+// static struct TryCatchRetryPolicy policy = {
+//   .delay = 1000000, .factor = 2.0, .maxDelay = 100000000, .jitter = 1.0};
+//
+// The statistics are updated without lock and can be read at any time with
+// TryCatchGetRetryStats.
+struct TryCatchRetryPolicy {
+
+  // Delay before the first retry, in nanoseconds
+  uint64_t delay;
+
+  // Factor applied to the delay after each retry
+  double factor;
+
+  // Maximum delay before a retry, in nanoseconds (0 for no maximum)
+  uint64_t maxDelay;
+
+  // Maximum fraction of the delay randomly removed from it, in [0, 1]
+  double jitter;
+
+  // Number of ended blocks, successfully or not
+  _Atomic uint64_t nbBlock;
+
+  // Number of attempts of the ended blocks
+  _Atomic uint64_t nbAttempt;
+
+  // Number of blocks ended by an exception
+  _Atomic uint64_t nbFailure;
+
+  // Sum and maximum of the time between the beginning of the first
+  // attempt and the end of the blocks, in nanoseconds
+  _Atomic uint64_t sumLatency;
+  _Atomic uint64_t maxLatency;
+
+};
+
+// Snapshot of the statistics of a backoff policy
+struct TryCatchRetryStats {
+
+  // Number of ended blocks, successfully or not
+  uint64_t nbBlock;
+
+  // Number of attempts of the ended blocks
+  uint64_t nbAttempt;
+
+  // Number of blocks ended by an exception
+  uint64_t nbFailure;
+
+  // Sum and maximum of the latency of the blocks, in nanoseconds
+  uint64_t sumLatency;
+  uint64_t maxLatency;
+
+};
+
+// Function called at the beginning of a TryRetry block to register its
+// number of attempts, backoff policy and retried exceptions
+// Inputs:
+//   maxAttempts: The maximum number of attempts of the block
+//        policy: The backoff policy (can be NULL for no delay and no
+//                statistics)
+//          excs: The list of retried exceptions, terminated by 0. The list
+//                must stay valid until the end of the block.
+void TryCatchSetNextRetry(
+                         int const maxAttempts,
+  struct TryCatchRetryPolicy* const policy,
+                   int const* const excs);
+
+// Function called at the beginning of each attempt of a TryRetry block,
+// waiting for the backoff delay if it is not the first attempt. The wait
+// is a checkpoint: TryCatchExc_Cancelled is raised if the cancellation of
+// the context is requested before or during the wait.
+// Input:
+//   site: Descriptor of the site of the block, where TryCatchExc_Cancelled
+//         is raised
+void TryCatchRetryAttempt(
+  struct TryCatchSite* const site);
+
+// Function to get the statistics of a backoff policy
+// Input:
+//   policy: The backoff policy
+// Output:
+//   Return a snapshot of the statistics
+struct TryCatchRetryStats TryCatchGetRetryStats(
+  struct TryCatchRetryPolicy* const policy);
+
+// Head of a TryCatch block attempted again when one of the exceptions
+// given in argument is raised, to be used as
+//
+// TryRetry (maxAttempts, &policy, /*... one or several exceptions ...*/) {
+//   /*... code of the TryCatch block here ...*/
+//
+// The code of the block is run again, after the backoff delay of the
+// policy, until it ends without one of the listed exceptions or has been
+// run maxAttempts times. The listed exceptions raised by the last attempt
+// go to the Catch segments of the block, other exceptions skip the block
+// as in a TryFor block. Exceptions raised from the Catch segments are not
+// retried. As with any TryCatch block, local variables modified in the
+// block and used after a raise must be volatile.
+//
+// Comments on the macro:
+//   // Guard against recursive incursion overflow
+//   TryCatchGuardOverflow();
+//   // Register the attempts, policy and list of retried exceptions
+//   TryCatchSetNextRetry(maxAttempts, policy, (int const[]){__VA_ARGS__, 0});
+//   // Memorise the jmp_buf on the top of the stack, setjmp returns 0
+//   // the first time and TryCatchRetryAgain for the next attempts
+//   switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {
+//     // Entry point for the code of the TryCatch block
+//     case TryCatchRetryAgain:
+//     case 0:
+//       // Count the attempt and wait for the backoff delay if necessary,
+//       // raising TryCatchExc_Cancelled from the site of the block if the
+//       // context is cancelled meanwhile
+//       {
+//         static struct TryCatchSite tryCatchRetrySite = {
+//           __FILE__, __LINE__, __func__, 0};
+//         TryCatchRetryAttempt(&tryCatchRetrySite);
+//       }
+#define TryRetry(maxAttempts, policy, ...)               \
+  TryCatchGuardOverflow();                               \
+  TryCatchSetNextRetry(                                  \
+    maxAttempts, policy, (int const[]){__VA_ARGS__, 0}); \
+  switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {      \
+    case TryCatchRetryAgain:                             \
+    case 0:                                              \
+      {                                                  \
+        static struct TryCatchSite tryCatchRetrySite = { \
+          __FILE__, __LINE__, __func__, 0};              \
+        TryCatchRetryAttempt(&tryCatchRetrySite);        \
+      }
+
+// States of a circuit breaker
+enum TryCatchBreakerState {
+
+  // The blocks run normally and their failures are counted
+  TryCatchBreakerState_Closed = 0,
+
+  // The blocks raise TryCatchExc_CircuitOpen without running
+  TryCatchBreakerState_Open,
+
+  // One block runs to probe the recovery, the others raise
+  // TryCatchExc_CircuitOpen without running
+  TryCatchBreakerState_HalfOpen
+
+};
+
+// Circuit breaker of TryBreaker blocks. The outcomes of the blocks are
+// counted by windows of 'window' blocks, if the rate of failures in a
+// window reaches 'threshold' the circuit opens for 'openDelay'
+// nanoseconds, then the next block is run as a probe: the circuit closes
+// if it succeeds, else it opens again. One breaker is meant to protect
+// one site, to be declared as, for example,
+//
+// static struct TryCatchBreaker breaker = {
+//   .window = 20, .threshold = 0.5, .openDelay = 1000000000};
+//
+// The state is updated without lock.
+struct TryCatchBreaker {
+
+  // Number of blocks over which the failure rate is measured
+  uint32_t window;
+
+  // Failure rate, in [0, 1], opening the circuit
+  double threshold;
+
+  // Time the circuit stays open before probing, in nanoseconds
+  uint64_t openDelay;
+
+  // Packed state (mode, number of blocks and failures in the window)
+  _Atomic uint64_t state;
+
+  // Time until which the circuit stays open, in nanoseconds since the
+  // Epoch
+  _Atomic uint64_t openUntil;
+
+  // Number of times the circuit has opened
+  _Atomic uint64_t nbOpen;
+
+  // Number of blocks not run because the circuit was open
+  _Atomic uint64_t nbShortCircuit;
+
+};
+
+// Function called at the beginning of a TryBreaker block to register its
+// circuit breaker
+// Input:
+//   breaker: The circuit breaker
+void TryCatchSetNextBreaker(
+  struct TryCatchBreaker* const breaker);
+
+// Function called at the beginning of the code of a TryBreaker block,
+// raising TryCatchExc_CircuitOpen if the circuit is open
+// Input:
+//   site: Descriptor of the site of the block, where the exception is
+//         raised
+void TryCatchBreakerEnter(
+  struct TryCatchSite* const site);
+
+// Function to get the state of a circuit breaker
+// Input:
+//   breaker: The circuit breaker
+// Output:
+//   Return the state
+enum TryCatchBreakerState TryCatchGetBreakerState(
+  struct TryCatchBreaker* const breaker);
+
+// Head of a TryCatch block protected by a circuit breaker, to be used as
+//
+// TryBreaker (&breaker) {
+//   /*... code of the TryCatch block here ...*/
+//
+// An exception caught by the block counts as a failure, reaching the end
+// of the block without exception counts as a success. When the circuit is
+// open, the code of the block is not run and TryCatchExc_CircuitOpen is
+// raised instead, it can be caught by the block itself to run a fallback.
+//
+// Comments on the macro:
+//   // Guard against recursive incursion overflow
+//   TryCatchGuardOverflow();
+//   // Register the circuit breaker
+//   TryCatchSetNextBreaker(breaker);
+//   // Memorise the jmp_buf on the top of the stack, setjmp returns 0
+//   switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {
+//     // Entry point for the code of the TryCatch block
+//     case 0:
+//       // Raise TryCatchExc_CircuitOpen from the site of the block if the
+//       // circuit is open
+//       {
+//         static struct TryCatchSite tryCatchBreakerSite = {
+//           __FILE__, __LINE__, __func__, 0};
+//         TryCatchBreakerEnter(&tryCatchBreakerSite);
+//       }
+#define TryBreaker(breaker)                                \
+  TryCatchGuardOverflow();                                 \
+  TryCatchSetNextBreaker(breaker);                         \
+  switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {        \
+    case 0:                                                \
+      {                                                    \
+        static struct TryCatchSite tryCatchBreakerSite = { \
+          __FILE__, __LINE__, __func__, 0};                \
+        TryCatchBreakerEnter(&tryCatchBreakerSite);        \
+      }
+
+// Function called at the beginning of a TryTransaction block
+void TryCatchSetNextTransaction(
+  void);
+
+// Function to save the bytes about to be modified by a write in the
+// running TryTransaction blocks, to restore them if the transaction is
+// rolled back. Does nothing outside of TryTransaction blocks.
+// TryCatchExc_MallocFailed is raised if the undo log couldn't be
+// extended.
+// Inputs:
+//    ptr: The address of the write
+//   size: The size of the write, in bytes
+void TryCatchLogWrite(
+  void const* const ptr,
+       size_t const size);
+
+// Head of a TryCatch block whose writes logged with TryCatchLogWrite are
+// rolled back if an exception is caught by the block or skips it, to be
+// used as
+//
+// TryTransaction {
+//   TryCatchLogWrite(&(data->a), sizeof(data->a));
+//   data->a = /*...*/;
+//   /*... code of the TryCatch block here ...*/
+//
+// The previous bytes are restored in reverse order of the writes before
+// entering the Catch segments. At the end of the block the log is
+// discarded, or merged in the log of the enclosing TryTransaction block
+// if any, to be rolled back with it.
+//
+// Comments on the macro:
+//   // Guard against recursive incursion overflow
+//   TryCatchGuardOverflow();
+//   // Flag the block as a transaction
+//   TryCatchSetNextTransaction();
+//   // Memorise the jmp_buf on the top of the stack, setjmp returns 0
+//   switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {
+//     // Entry point for the code of the TryCatch block
+//     case 0:
+#define TryTransaction                              \
+  TryCatchGuardOverflow();                          \
+  TryCatchSetNextTransaction();                     \
+  switch (setjmp(*TryCatchGetJmpBufOnStackTop())) { \
+    case 0:
+
 // Catch segment in the TryCatch block, to be used as
 //
 // Catch (/*... one of TryCatchException or user-defined exception ...*/) {
@@ -179,37 +672,535 @@ void TryCatchEnd(
   }                             \
   TryCatchEnd()
 
+// Descriptor of a raise site, statically allocated for each use of Raise
+struct TryCatchSite {
+
+  // File, line and function of the site
+  char const* const filename;
+  int const line;
+  char const* const func;
+
+  // Index of the site, unique among all the sites, attributed at its
+  // first use by TryCatchGetSiteId (0 until then)
+  _Atomic unsigned int id;
+
+};
+
 // Function called to raise the TryCatchException 'exc'
 // Inputs:
-//        exc: The TryCatchException to raise. Do not use the type enum
-//             TryCatchException to allow the user to extend the list of
-//             exceptions with user-defined exception outside of enum
-//             TryCatchException.
-//   filename: File where the exception has been raised
-//       line: Line where the exception has been raised
+//    exc: The TryCatchException to raise. Do not use the type enum
+//         TryCatchException to allow the user to extend the list of
+//         exceptions with user-defined exception outside of enum
+//         TryCatchException.
+//   site: Descriptor of the site where the exception has been raised
 void Raise_(
-                int exc,
-  char const* const filename,
-          int const line);
+                        int exc,
+  struct TryCatchSite* const site);
 
-// Wrapper to call Raise_ with file name and line number
-#define Raise(e) Raise_(e, __FILE__, __LINE__)
+// Wrapper to call Raise_ with the descriptor of the site of the raise. It
+// declares the static descriptor of the site, hence it is a statement and
+// can't be used as an expression (write 'if (c) Raise(e);' instead of
+// 'c ? Raise(e) : (void)0').
+#define Raise(e)                                      \
+  do {                                                \
+    static struct TryCatchSite tryCatchRaiseSite = {  \
+      __FILE__, __LINE__, __func__, 0};               \
+    Raise_(e, &tryCatchRaiseSite);                    \
+  } while (false)
+
+// Function to raise the TryCatchException 'exc' from a signal handler.
+// Unlike Raise, it is async-signal-safe: the exception is neither printed
+// on the raise stream nor recorded in the binary trace (whose writers may
+// be the interrupted code), and the context is not created if the thread
+// has none. The site of the exception is unknown.
+// Input:
+//   exc: The TryCatchException to raise
+// Output:
+//   Doesn't return if the current thread is in a TryCatch block, else
+//   return false
+bool TryCatchRaiseFromSignal(
+  int const exc);
+
+// Function handling a resumable exception
+// Inputs:
+//     exc: The raised exception
+//   value: The value given to RaiseResumable, to be replaced by the
+//          handler (its type is defined by the exception)
+//    site: Descriptor of the site where the exception has been raised
+// Output:
+//   Return true if the handler has supplied the value, then the execution
+//   resumes at the raise site, or false to decline and let the next
+//   handler or the TryCatch blocks handle the exception
+typedef bool (*TryCatchResumeFun)(
+                         int exc,
+                       void* value,
+  struct TryCatchSite const* site);
+
+// Function to add a handler of a resumable exception. The handlers are
+// called without unwinding, the last added first, until one supplies the
+// value. The handlers belong to the context of the current thread: they
+// handle the exceptions raised by this thread only, and follow the
+// context if it's attached to another thread.
+// Inputs:
+//   exc: The exception
+//   fun: The handler
+// Output:
+//   Return true if the handler could be added, false if there are already
+//   TryCatchMaxNbResumeFun handlers or the memory couldn't be allocated
+bool TryCatchAddResumeFun(
+                int const exc,
+  TryCatchResumeFun const fun);
+
+// Function to remove a handler of a resumable exception from the context
+// of the current thread
+// Inputs:
+//   exc: The exception
+//   fun: The handler
+void TryCatchRemoveResumeFun(
+                int const exc,
+  TryCatchResumeFun const fun);
+
+// Function called to raise the resumable TryCatchException 'exc'. The
+// handlers of the exception are called first and can supply a
+// replacement value, in which case the function returns and the execution
+// continues at the raise site. If they all decline, the exception is
+// raised as with Raise_.
+// Inputs:
+//     exc: The TryCatchException to raise
+//   value: The value to be replaced by the handlers
+//    site: Descriptor of the site where the exception has been raised
+void RaiseResumable_(
+                        int exc,
+                      void* value,
+  struct TryCatchSite* const site);
+
+// Wrapper to call RaiseResumable_ with the descriptor of the site of the
+// raise
+#define RaiseResumable(e, v)                         \
+  do {                                               \
+    static struct TryCatchSite tryCatchRaiseSite = { \
+      __FILE__, __LINE__, __func__, 0};              \
+    RaiseResumable_(e, v, &tryCatchRaiseSite);       \
+  } while (false)
+
+// Kinds of latency measured for the TryTimed blocks
+enum TryCatchLatencyKind {
+
+  // Duration of the block, from its entrance to its end
+  TryCatchLatencyKind_Block,
+
+  // Duration of the unwinding, from the raise of an exception to the
+  // entrance in the Catch segment of the block
+  TryCatchLatencyKind_Unwind,
+
+  TryCatchLatencyKind_LastID
+
+};
+
+// Snapshot of the latency histogram of a site, merged over all threads
+struct TryCatchLatencyStats {
+
+  // Number of samples
+  uint64_t nbSample;
+
+  // Mean of the samples, in nanoseconds
+  uint64_t mean;
+
+  // Percentiles 50%, 99% and 99.9% of the samples, in nanoseconds
+  // (upper bound of the bucket of the histogram containing them)
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t p999;
+
+};
+
+// Function called at the beginning of a TryTimed block to register its
+// site, if the block is sampled
+// Input:
+//   site: The site of the block
+void TryCatchSetNextTimed(
+  struct TryCatchSite* const site);
+
+// Head of a TryCatch block whose latencies are measured, to be used as
+//
+// TryTimed {
+//   /*... code of the TryCatch block here ...*/
+//
+// When the latency sampling is on (see TryCatchSetLatencySampling), the
+// duration of the sampled blocks and the time from the raise of an
+// exception to the entrance in their Catch segment are recorded in
+// per-site histograms.
+//
+// Comments on the macro:
+//   // Guard against recursive incursion overflow
+//   TryCatchGuardOverflow();
+//   // Register the site of the block
+//   {
+//     static struct TryCatchSite tryCatchTimedSite = {
+//       __FILE__, __LINE__, __func__, 0};
+//     TryCatchSetNextTimed(&tryCatchTimedSite);
+//   }
+//   // Memorise the jmp_buf on the top of the stack, setjmp returns 0
+//   switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {
+//     // Entry point for the code of the TryCatch block
+//     case 0:
+#define TryTimed                                     \
+  TryCatchGuardOverflow();                           \
+  {                                                  \
+    static struct TryCatchSite tryCatchTimedSite = { \
+      __FILE__, __LINE__, __func__, 0};              \
+    TryCatchSetNextTimed(&tryCatchTimedSite);        \
+  }                                                  \
+  switch (setjmp(*TryCatchGetJmpBufOnStackTop())) {  \
+    case 0:
+
+// Function to set the sampling of the latencies of the TryTimed blocks.
+// Each thread samples one TryTimed block out of 'period' it enters,
+// which bounds the overhead on hot sites. The sampling is off by
+// default. The samples are recorded in log-linear histograms (relative
+// precision of 1/8) per thread and per site, merged when read.
+// Input:
+//   period: The sampling period, 1 to sample all the blocks, 0 to turn
+//           off the sampling
+void TryCatchSetLatencySampling(
+  unsigned int const period);
+
+// Function to get the latency histogram of a site, merged over all
+// threads
+// Inputs:
+//   siteId: The index of the site (see TryCatchGetSiteId)
+//     kind: The kind of latency
+// Output:
+//   Return a snapshot of the statistics of the histogram
+struct TryCatchLatencyStats TryCatchGetLatencyStats(
+                unsigned int const siteId,
+  enum TryCatchLatencyKind const kind);
+
+// Function to print the statistics of the latency histograms of all the
+// sites having samples
+// Input:
+//   stream: The stream where to print
+void TryCatchDumpLatency(
+  FILE* const stream);
+
+// Value of a TryCatchResult
+union TryCatchValue {
+
+  void* ptr;
+  int64_t i;
+  double f;
+
+};
+
+// Result of a function whose failures are expected and frequent, returned
+// instead of raising an exception to avoid the cost of the longjmp. It
+// contains either a value, or the ID of an exception and the site where
+// the failure happened. The caller can check it inline or escalate the
+// failure to a real exception with TryCatchUnwrap.
+struct TryCatchResult {
+
+  // ID of the exception, 0 if the result is a value
+  int exc;
+
+  // Site of the failure, NULL if the result is a value
+  struct TryCatchSite* site;
+
+  // Value of the result, if it's not a failure
+  union TryCatchValue val;
+
+};
+
+// Macros to create a TryCatchResult containing a value, to be used as
+//
+// return TryCatchOkInt(42);
+#define TryCatchOkPtr(v) ((struct TryCatchResult){.val.ptr = (v)})
+#define TryCatchOkInt(v) ((struct TryCatchResult){.val.i = (v)})
+#define TryCatchOkFloat(v) ((struct TryCatchResult){.val.f = (v)})
+
+// Macro to return a TryCatchResult containing the failure 'e' with the
+// descriptor of the site of the failure, to be used as
+//
+// if (/*... failure ...*/) TryCatchReturnFail(TryCatchExc_IOError);
+#define TryCatchReturnFail(e)                        \
+  do {                                               \
+    static struct TryCatchSite tryCatchRaiseSite = { \
+      __FILE__, __LINE__, __func__, 0};              \
+    return (struct TryCatchResult){                  \
+      .exc = (e), .site = &tryCatchRaiseSite};       \
+  } while (false)
+
+// Macro to check if a TryCatchResult contains a value
+#define TryCatchIsOk(res) ((res).exc == 0)
+
+// Function to get the value of a TryCatchResult, raising its exception
+// from its site if it's a failure
+// Input:
+//   res: The result
+// Output:
+//   Return the value of the result
+union TryCatchValue TryCatchUnwrap(
+  struct TryCatchResult const res);
+
+// Function called to raise the TryCatchException 'exc'
+// Inputs:
+//    ctx: The context
+//    exc: The TryCatchException to raise. Do not use the type enum
+//         TryCatchException to allow the user to extend the list of
+//         exceptions with user-defined exception outside of enum
+//         TryCatchException.
+//   site: Descriptor of the site where the exception has been raised
+void RaiseCtx_(
+   struct TryCatchCtx* const ctx,
+                         int exc,
+  struct TryCatchSite* const site);
+
+// Wrapper to call RaiseCtx_ with the descriptor of the site of the raise
+#define RaiseCtx(ctx, e)                             \
+  do {                                               \
+    static struct TryCatchSite tryCatchRaiseSite = { \
+      __FILE__, __LINE__, __func__, 0};              \
+    RaiseCtx_(ctx, e, &tryCatchRaiseSite);           \
+  } while (false)
+
+// Variants of the Try, Catch, CatchAlso, CatchDefault and EndCatch macros
+// using an explicit context, to be used as
+//
+// struct TryCatchCtx* ctx = TryCatchGetCtx();
+// TryCtx(ctx) {
+//   /*... code of the TryCatch block here, using RaiseCtx(ctx, e) ...*/
+// } CatchCtx(ctx, /*... exception ...*/) {
+//   /*...*/
+// } CatchDefaultCtx(ctx) {
+//   /*...*/
+// } EndCatchCtx(ctx);
+//
+// The context is evaluated several times, it should be a variable.
+#define TryCtx(ctx)                                       \
+  TryCatchCtxGuardOverflow(ctx);                          \
+  switch (setjmp(*TryCatchCtxGetJmpBufOnStackTop(ctx))) { \
+    case 0:
+
+#define CatchCtx(ctx, e)              \
+      TryCatchCtxExitCatchBlock(ctx); \
+      break;                          \
+    case e:                           \
+      TryCatchCtxEnterCatchBlock(ctx);
+
+#define CatchAlsoCtx(ctx, e) \
+      /* fall through */     \
+    case e:                  \
+      TryCatchCtxEnterCatchBlock(ctx);
+
+#define CatchDefaultCtx(ctx)          \
+      TryCatchCtxExitCatchBlock(ctx); \
+      break;                          \
+    default:                          \
+      TryCatchCtxEnterCatchBlock(ctx);
+
+#define EndCatchCtx(ctx)              \
+      TryCatchCtxExitCatchBlock(ctx); \
+      break;                          \
+  }                                   \
+  TryCatchCtxEnd(ctx)
+
+// Function to get the index of a raise site, attributing it if necessary.
+// Indices are attributed in order of first use, starting at 1, up to
+// TryCatchGetNbSite() - 1. Sites beyond the capacity of the table of
+// sites all share an index for which TryCatchGetSite returns NULL.
+// Input:
+//   site: The site
+// Output:
+//   Return the index of the site
+unsigned int TryCatchGetSiteId(
+  struct TryCatchSite* const site);
+
+// Function to get a raise site from its index
+// Input:
+//   id: The index of the site
+// Output:
+//   Return the site, or NULL if there is no site for this index
+struct TryCatchSite const* TryCatchGetSite(
+  unsigned int const id);
+
+// Function to get the number of attributed site indices
+// Output:
+//   Return the number of indices (including the unused index 0)
+unsigned int TryCatchGetNbSite(
+  void);
+
+// Function to forget the sites located in a range of memory about to be
+// unmapped, like a shared library before dlclose. The sites of the range
+// in the table of raise sites are replaced by copies owned by TryCatchC,
+// whose indices are given back to the identical sites if the library is
+// loaded again. The sites of the range recorded until now as last raised
+// site (see TryCatchGetLastSite) or in the flight recorder become
+// unknown. The sites of the range must not be used anymore afterward.
+// Inputs:
+//   start: The start of the range
+//    size: The size of the range in bytes
+void TryCatchForgetSites(
+  void const* const start,
+       size_t const size);
+
+// Flag to memorise if the fault injection is on, do not modify it
+// directly
+extern _Atomic bool tryCatchInjectionOn;
+
+// Function called by TryCatchInjectionPoint when the fault injection is
+// on, raising the exception of the first rule matching the site if its
+// condition is met
+// Input:
+//   site: Descriptor of the injection point
+void TryCatchInject_(
+  struct TryCatchSite* const site);
+
+// Fault injection point, raising an exception according to the fault
+// injection rules matching its site. To be used in the functions checking
+// allocation, I/O, arithmetic, etc. where the exception can be raised
+// anyway, to test the error paths. When the fault injection is off, its
+// cost is a single branch.
+#define TryCatchInjectionPoint()                           \
+  do {                                                     \
+    if (                                                   \
+      atomic_load_explicit(                                \
+        &tryCatchInjectionOn,                              \
+        memory_order_relaxed)) {                           \
+      static struct TryCatchSite tryCatchInjectionSite = { \
+        __FILE__, __LINE__, __func__, 0};                  \
+      TryCatchInject_(&tryCatchInjectionSite);             \
+    }                                                      \
+  } while (false)
+
+// Function to add fault injection rules and turn on the fault injection.
+// Rules are separated by ';' or new lines, and have the syntax
+// '<site> <exception> <condition>' where:
+//        site: 'file:line', 'file' (any line of the file) or '*' (any
+//              site), the file being the end of the file path of the
+//              injection point
+//   exception: name of a TryCatchException (e.g. TryCatchExc_IOError) or
+//              ID of the exception
+//   condition: 'p=<probability>' to raise the exception at random with
+//              the given probability, or 'every=<n>' to raise it every
+//              n-th time the sites of the rule are reached
+// The first rule matching an injection point applies. A rule 'seed=<n>'
+// sets the seed as TryCatchSetInjectionSeed. Text after '#' up to the
+// end of the line is ignored. Rules longer than 511 characters are
+// invalid. Rules should be added before starting other threads.
+// Input:
+//   rules: The rules
+// Output:
+//   Return true if all the rules are valid, else false (valid rules are
+//   added anyway)
+bool TryCatchAddInjectionRules(
+  char const* const rules);
+
+// Function to turn on the fault injection with the rules given in the
+// environment variable TRYCATCH_INJECT and in the file whose path is
+// given in the environment variable TRYCATCH_INJECT_FILE, if set (see
+// TryCatchAddInjectionRules for the syntax)
+// Output:
+//   Return true if the rules are valid, else false
+bool TryCatchInitInjection(
+  void);
+
+// Function to set the seed of the pseudo random generators of the fault
+// injection. Each thread has its own generator, seeded with this seed and
+// its ID, making the injections reproducible for a given seed as long as
+// threads reach the injection points in the same order. The generators
+// of all the threads are seeded again at their next use.
+// Input:
+//   seed: The seed
+void TryCatchSetInjectionSeed(
+  uint64_t const seed);
+
+// Function to turn off the fault injection and remove all its rules
+void TryCatchClearInjection(
+  void);
 
 // Macro to recatch and forward an exception. This is usefull when an exception
 // may be raised by a handler, in which case the trace loose track of where
 // the exception has occured. By ReCatch-ing the block of code B susceptible
 // of triggering the handler, one can ensure the trace will properly indicates
-// this block of code as the source of the exception.
-#define Recatch(B)                                \
-  do {                                            \
-    Try { B; }                                    \
-    CatchDefault { Raise(TryCatchGetLastExc()); } \
-    EndCatch;                                     \
+// this block of code as the source of the exception. The exception is
+// raised again after the end of the block, as raising it from its catch
+// segment would jump back to the same block.
+#define Recatch(B)                                              \
+  do {                                                          \
+    volatile int tryCatchRecatchExc = 0;                        \
+    Try { B; }                                                  \
+    CatchDefault { tryCatchRecatchExc = TryCatchGetLastExc(); } \
+    EndCatch;                                                   \
+    if (tryCatchRecatchExc != 0) Raise(tryCatchRecatchExc);     \
   } while(false)
 
-// The struct siginfo_t used to handle the SIGSEV is not defined in
-// ANSI C, guard against this.
-#ifndef __STRICT_ANSI__
+// Failure of an element processed by TryEach
+struct TryCatchEachFailure {
+
+  // Index of the element
+  size_t index;
+
+  // ID of the exception raised while processing the element
+  int exc;
+
+};
+
+// Function applied to the elements by TryEach
+// Input:
+//   elem: Pointer to the element
+typedef void (*TryCatchEachFun)(
+  void* elem);
+
+// Function to apply a function to each element of an array, isolating
+// the failure of each element: if an exception is raised while
+// processing an element, its index and the exception are added to the
+// list of failures and the processing resumes at the next element. Only
+// one TryCatch block is entered for the whole array, the cost of the
+// isolation is paid only by the failing elements.
+// Inputs:
+//      array: The array
+//     nbElem: The number of elements in the array
+//   sizeElem: The size in bytes of one element
+//        fun: The function applied to the elements
+//   failures: Where to store the list of failures in order of index,
+//             allocated with malloc and to be freed by the user, NULL if
+//             there is no failure (can be NULL if the list is not needed)
+//       site: Descriptor of the site of the call, where
+//             TryCatchExc_MallocFailed is raised
+// Output:
+//   Return the number of failures. TryCatchExc_MallocFailed is raised if
+//   the list of failures couldn't be allocated.
+size_t TryCatchEach_(
+                         void* const array,
+                        size_t const nbElem,
+                        size_t const sizeElem,
+               TryCatchEachFun const fun,
+  struct TryCatchEachFailure** const failures,
+           struct TryCatchSite* const site);
+
+// Wrapper to call TryCatchEach_ on an array of typed elements with the
+// descriptor of the site of the call, to be used as
+//
+// struct TryCatchEachFailure* failures = NULL;
+// size_t nbFailure = 0;
+// TryEach(array, nbElem, fun, &failures, nbFailure);
+// /*... process the failures ...*/
+// free(failures);
+//
+// The number of failures is assigned to 'nbFailure'. It declares the
+// static descriptor of the site, hence it is a statement.
+#define TryEach(array, nbElem, fun, failures, nbFailure) \
+  do {                                                   \
+    static struct TryCatchSite tryCatchEachSite = {      \
+      __FILE__, __LINE__, __func__, 0};                  \
+    (nbFailure) =                                        \
+      TryCatchEach_(                                     \
+        array, nbElem, sizeof(*(array)), fun, failures,  \
+        &tryCatchEachSite);                              \
+  } while (false)
+
+// The struct siginfo_t used to handle the SIGSEV is POSIX only, guard
+// against this.
+#if TryCatchPosix
 
 // Function to set the handler function of the signal SIGSEV and raise
 // TryCatchExc_Segv upon reception of this signal. Must have been
@@ -217,14 +1208,123 @@ void Raise_(
 void TryCatchInitHandlerSigSegv(
   void);
 
+// Function to set the handler function of the signal SIGBUS and raise
+// TryCatchExc_IOError upon reception of this signal (access beyond the
+// end of a mapped file). The handler is process wide and replaces any
+// handler previously set for SIGBUS.
+void TryCatchInitHandlerSigBus(
+  void);
+
+// Function to copy memory from a location which may be invalid, like a
+// pointer given by an untrusted plugin or a mapped file which may have
+// been truncated. TryCatchExc_Segv is raised if the source is not
+// readable, TryCatchExc_IOError if it is beyond the end of a mapped file.
+// The handlers of the signals must have been set with
+// TryCatchInitHandlerSigSegv and TryCatchInitHandlerSigBus, else a fault
+// ends the process as without probe.
+// Inputs:
+//    dst: The destination
+//    src: The probed source
+//    len: The number of bytes to copy
+//   site: Descriptor of the site of the probe
+void TryCatchProbeRead_(
+                void* const dst,
+          void const* const src,
+               size_t const len,
+  struct TryCatchSite* const site);
+
+// Wrapper to call TryCatchProbeRead_ with the descriptor of the site of
+// the probe, the exception being raised again from this site
+#define TryCatchProbeRead(dst, src, len)                   \
+  do {                                                     \
+    static struct TryCatchSite tryCatchProbeSite = {       \
+      __FILE__, __LINE__, __func__, 0};                    \
+    TryCatchProbeRead_(dst, src, len, &tryCatchProbeSite); \
+  } while (false)
+
+// Function to copy memory to a location which may be invalid, like a
+// pointer given by an untrusted plugin or a mapped file which may have
+// been truncated. TryCatchExc_Segv is raised if the destination is not
+// writable, TryCatchExc_IOError if it is beyond the end of a mapped file.
+// The handlers of the signals must have been set with
+// TryCatchInitHandlerSigSegv and TryCatchInitHandlerSigBus, else a fault
+// ends the process as without probe.
+// Inputs:
+//    dst: The probed destination
+//    src: The source
+//    len: The number of bytes to copy
+//   site: Descriptor of the site of the probe
+void TryCatchProbeWrite_(
+                void* const dst,
+          void const* const src,
+               size_t const len,
+  struct TryCatchSite* const site);
+
+// Wrapper to call TryCatchProbeWrite_ with the descriptor of the site of
+// the probe, the exception being raised again from this site
+#define TryCatchProbeWrite(dst, src, len)                   \
+  do {                                                      \
+    static struct TryCatchSite tryCatchProbeSite = {        \
+      __FILE__, __LINE__, __func__, 0};                     \
+    TryCatchProbeWrite_(dst, src, len, &tryCatchProbeSite); \
+  } while (false)
+
 #endif
 
+// Function to turn on the flight recorder. The last events (entrance and
+// exit of TryCatch blocks, raise, catch) of each thread are kept in memory
+// and dumped on the standard error output when an exception is raised
+// outside of any TryCatch block, and (POSIX feature) when the process
+// receives a fatal signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT) which
+// has no handler.
+void TryCatchInitFlightRecorder(
+  void);
+
+// Function to dump the flight recorder of all the threads on the standard
+// error output. It is async-signal-safe, except when the POSIX features
+// are left out.
+void TryCatchDumpFlightRecorder(
+  void);
+
 // Function to get the ID of the last raised exception
 // Output:
 //   Return the id of the last raised exception
 int TryCatchGetLastExc(
   void);
 
+// Function to get the number of TryCatch blocks currently running in the
+// current thread
+// Output:
+//   Return the level in the stack of TryCatch blocks
+int TryCatchGetLevel(
+  void);
+
+// Function to end the TryCatch blocks above a level in the stack of the
+// current thread, left open by code returning from inside them without
+// reaching their EndCatch. They end as if skipped by an exception, except
+// the probe of a circuit breaker which releases its slot to the next block
+// of the breaker. Does nothing if the level is not below the current one.
+// Input:
+//   lvl: The level to restore, as returned by TryCatchGetLevel
+void TryCatchRestoreLevel(
+  int const lvl);
+
+// Function to get the site of the last raised exception
+// Output:
+//   Return the site, or NULL if it's unknown (for example for exceptions
+//   raised by the handler of SIGSEGV, or sites forgotten since by
+//   TryCatchForgetSites)
+struct TryCatchSite const* TryCatchGetLastSite(
+  void);
+
+// Function to get the ID of the last raised exception
+// Input:
+//   ctx: The context
+// Output:
+//   Return the id of the last raised exception
+int TryCatchCtxGetLastExc(
+  struct TryCatchCtx const* const ctx);
+
 // Function to convert an exception ID to char*
 // Input:
 //   exc: The exception ID
@@ -252,6 +1352,107 @@ void TryCatchAddExcToStrFun(
 void TryCatchSetRaiseStream(
   FILE* const stream);
 
+// Magic string at the head of a binary trace file
+#define TryCatchTraceMagic "TCCTRACE"
+
+// Version of the binary trace file format
+#define TryCatchTraceVersion 1
+
+// Kinds of records in a binary trace file
+enum TryCatchTraceKind {
+
+  // Unused record, marks the end of the data in the file
+  TryCatchTraceKind_Empty = 0,
+
+  // Raised exception
+  TryCatchTraceKind_Raise,
+
+  // Definition of a raise site, followed by the name of the file of the
+  // site split into as many raw records as necessary
+  TryCatchTraceKind_Site
+
+};
+
+// Header of a binary trace file
+struct TryCatchTraceHeader {
+
+  // Magic string (TryCatchTraceMagic, without the null character)
+  char magic[8];
+
+  // Version of the format (TryCatchTraceVersion)
+  uint32_t version;
+
+  // Size in bytes of one record
+  uint32_t recordSize;
+
+  // Creation time of the file, in nanoseconds since the Epoch
+  uint64_t timestamp;
+
+  // Maximum size in bytes of the file
+  uint64_t capacity;
+
+};
+
+// Maximum length of the file name of a site in a binary trace file, which
+// bounds the size of a site definition to fit in an empty file
+#define TryCatchTraceMaxLenFilename 256
+
+// Fixed-width record of a binary trace file. The records follow the header
+// until the end of the file or the first record of kind
+// TryCatchTraceKind_Empty.
+// For a record of kind TryCatchTraceKind_Raise:
+//   timestamp: time of the raise, in nanoseconds since the Epoch
+//      thread: ID of the raising thread (attributed by TryCatch)
+//         exc: ID of the raised exception
+//        site: ID of the site of the raise
+//       level: level of the TryCatch block stack when raised
+// For a record of kind TryCatchTraceKind_Site:
+//   timestamp: time of the definition, in nanoseconds since the Epoch
+//      thread: length of the file name of the site
+//         exc: line of the site
+//        site: ID of the site
+//       level: unused
+// and the file name of the site (without null character) follows in
+// the ceil(thread / sizeof(struct TryCatchTraceRecord)) next records. The
+// file names longer than TryCatchTraceMaxLenFilename are truncated to
+// their last TryCatchTraceMaxLenFilename characters.
+// A site definition is written once per file, before or after the first
+// raise referring to it.
+struct TryCatchTraceRecord {
+
+  uint64_t timestamp;
+  uint32_t thread;
+  int32_t exc;
+  uint32_t site;
+  uint16_t level;
+  uint8_t kind;
+  uint8_t reserved;
+
+};
+
+// The binary trace file is based on mmap which is POSIX only, guard
+// against this.
+#if TryCatchPosix
+
+// Set the file on which to record exception raising in the compact binary
+// format, in addition to the stream set with TryCatchSetRaiseStream. The
+// file is memory-mapped and records are appended without lock. When the
+// file is full it is renamed with the suffix '.1' (replacing the previous
+// one if any) and a new file is started, hence at most twice 'maxSize'
+// bytes are used on disk. Use the tool trycatchcdecode to convert the files
+// to text.
+// Inputs:
+//      path: Path of the trace file, set it to NULL to close the current
+//            trace file
+//   maxSize: Maximum size in bytes of one file
+// Output:
+//   Return true if the file could be created, else false
+bool TryCatchSetRaiseTraceFile(
+  char const* const path,
+       size_t const maxSize);
+
+#endif
+
 // Function to get the commit id of the library
 // Output:
 //   Return a string containing the result of `git rev-parse HEAD` at
@@ -0,0 +1,432 @@
+// ------------------ trycatchcdecode.c ------------------
+
+// Tool to convert the binary trace files created with
+// TryCatchSetRaiseTraceFile to text or CSV, and to print statistics about
+// the raised exceptions.
+// Usage:
+//   trycatchcdecode [-csv] [-top <n>] [-hist] <file> [<file> ...]
+//     -csv: print the raises in CSV format instead of text
+//     -top <n>: print only the <n> sites with the most raises
+//     -hist: print only the number of raises per second
+// Several files of the same trace (for example 'trace.1' and 'trace')
+// can be given, they are decoded in the order of the arguments.
+
+// Include external modules header
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Site of raises defined in the trace files
+struct Site {
+
+  // ID of the site in the trace files
+  uint32_t id;
+
+  // File and line of the site
+  char* filename;
+  int line;
+
+  // Number of raises from this site
+  unsigned long nbRaise;
+
+};
+
+// Table of the sites, in order of definition
+static struct Site* sites = NULL;
+static size_t nbSite = 0;
+
+// Number of raises per second since the first raise
+static unsigned long* histogram = NULL;
+static size_t nbSecond = 0;
+
+// Timestamp of the first raise
+static uint64_t firstTimestamp = 0;
+
+// Options of the tool
+static bool optCsv = false;
+static unsigned long optTop = 0;
+static bool optHist = false;
+
+// Function to get a site by its ID
+// Input:
+//   id: The ID of the site
+// Output:
+//   Return a pointer to the site, or NULL if it hasn't been defined
+static struct Site* GetSite(
+  uint32_t const id) {
+
+  // Search the site, latest definition first
+  for (
+    size_t iSite = nbSite;
+    iSite > 0;
+    --iSite) {
+
+    if (sites[iSite - 1].id == id) return sites + iSite - 1;
+
+  }
+
+  return NULL;
+
+}
+
+// Function to add the definition of a site
+// Inputs:
+//         id: The ID of the site
+//   filename: The file name of the site (not null terminated)
+//        len: The length of the file name
+//       line: The line of the site
+static void AddSite(
+      uint32_t const id,
+  char const* const filename,
+        size_t const len,
+           int const line) {
+
+  // Skip the site if it's already known from a previous file
+  struct Site* site = GetSite(id);
+  if (
+    site != NULL &&
+    site->line == line &&
+    strlen(site->filename) == len &&
+    memcmp(site->filename, filename, len) == 0) {
+
+    return;
+
+  }
+
+  // Add the site
+  struct Site* ptr =
+    realloc(
+      sites,
+      (nbSite + 1) * sizeof(struct Site));
+  char* name = malloc(len + 1);
+  if (ptr == NULL || name == NULL) {
+
+    fprintf(
+      stderr,
+      "trycatchcdecode: out of memory\n");
+    exit(EXIT_FAILURE);
+
+  }
+
+  memcpy(
+    name,
+    filename,
+    len);
+  name[len] = '\0';
+  sites = ptr;
+  sites[nbSite] = (struct Site){
+    .id = id,
+    .filename = name,
+    .line = line,
+    .nbRaise = 0
+  };
+  ++nbSite;
+
+}
+
+// Function to process one raise record
+// Input:
+//   rec: The record
+static void ProcessRaise(
+  struct TryCatchTraceRecord const* const rec) {
+
+  // Get the site of the raise
+  struct Site* site = GetSite(rec->site);
+  if (site != NULL) ++(site->nbRaise);
+
+  // If we are printing the histogram
+  if (optHist) {
+
+    // Update the count for the second of the raise, raises older than the
+    // first one (possible due to concurrent writers) are counted in the
+    // first second
+    if (firstTimestamp == 0) firstTimestamp = rec->timestamp;
+    size_t iSecond =
+      (rec->timestamp > firstTimestamp ?
+        (size_t)((rec->timestamp - firstTimestamp) / 1000000000u) : 0);
+    if (iSecond >= nbSecond) {
+
+      unsigned long* ptr =
+        realloc(
+          histogram,
+          (iSecond + 1) * sizeof(unsigned long));
+      if (ptr == NULL) {
+
+        fprintf(
+          stderr,
+          "trycatchcdecode: out of memory\n");
+        exit(EXIT_FAILURE);
+
+      }
+
+      histogram = ptr;
+      memset(
+        histogram + nbSecond,
+        0,
+        (iSecond + 1 - nbSecond) * sizeof(unsigned long));
+      nbSecond = iSecond + 1;
+
+    }
+
+    ++(histogram[iSecond]);
+
+  // Else, if we are printing the raises
+  } else if (optTop == 0) {
+
+    char const* filename = (site != NULL ? site->filename : "?");
+    int line = (site != NULL ? site->line : 0);
+    if (optCsv) {
+
+      printf(
+        "%" PRIu64 ",%" PRIu32 ",%" PRId32 ",\"%s\",\"%s\",%d,%" PRIu16 "\n",
+        rec->timestamp,
+        rec->thread,
+        rec->exc,
+        TryCatchExcToStr(rec->exc),
+        filename,
+        line,
+        rec->level);
+
+    } else {
+
+      printf(
+        "%" PRIu64 ".%09" PRIu64 " thread %" PRIu32 " level %" PRIu16
+        " exception (%s) raised in %s, line %d.\n",
+        rec->timestamp / 1000000000u,
+        rec->timestamp % 1000000000u,
+        rec->thread,
+        rec->level,
+        TryCatchExcToStr(rec->exc),
+        filename,
+        line);
+
+    }
+
+  }
+
+}
+
+// Function to decode one trace file
+// Input:
+//   path: The path of the file
+// Output:
+//   Return true if the file could be decoded, else false
+static bool DecodeFile(
+  char const* const path) {
+
+  // Load the whole file
+  FILE* fp = fopen(path, "rb");
+  if (fp == NULL) {
+
+    fprintf(
+      stderr,
+      "trycatchcdecode: can't open %s\n",
+      path);
+    return false;
+
+  }
+
+  struct TryCatchTraceHeader header;
+  size_t nbRecord = 0;
+  struct TryCatchTraceRecord* recs = NULL;
+  bool ret =
+    fread(&header, sizeof(header), 1, fp) == 1 &&
+    memcmp(header.magic, TryCatchTraceMagic, sizeof(header.magic)) == 0 &&
+    header.version == TryCatchTraceVersion &&
+    header.recordSize == sizeof(struct TryCatchTraceRecord);
+  if (ret) {
+
+    nbRecord =
+      (header.capacity - sizeof(header)) / sizeof(struct TryCatchTraceRecord);
+    recs = calloc(nbRecord + 1, sizeof(struct TryCatchTraceRecord));
+    ret = (recs != NULL);
+    if (ret) {
+
+      nbRecord =
+        fread(
+          recs,
+          sizeof(struct TryCatchTraceRecord),
+          nbRecord,
+          fp);
+
+    }
+
+  }
+
+  fclose(fp);
+  if (ret == false) {
+
+    fprintf(
+      stderr,
+      "trycatchcdecode: %s is not a valid trace file\n",
+      path);
+    free(recs);
+    return false;
+
+  }
+
+  // First pass on the records to get the sites definitions, as a raise
+  // may have been written before the definition of its site by a
+  // concurrent writer
+  for (
+    size_t iRec = 0;
+    iRec < nbRecord && recs[iRec].kind != TryCatchTraceKind_Empty;
+    ++iRec) {
+
+    if (recs[iRec].kind == TryCatchTraceKind_Site) {
+
+      size_t nbChunk =
+        (recs[iRec].thread + sizeof(struct TryCatchTraceRecord) - 1) /
+        sizeof(struct TryCatchTraceRecord);
+      if (iRec + nbChunk >= nbRecord) break;
+      AddSite(
+        recs[iRec].site,
+        (char const*)(recs + iRec + 1),
+        recs[iRec].thread,
+        recs[iRec].exc);
+      iRec += nbChunk;
+
+    }
+
+  }
+
+  // Second pass on the records to process the raises
+  for (
+    size_t iRec = 0;
+    iRec < nbRecord && recs[iRec].kind != TryCatchTraceKind_Empty;
+    ++iRec) {
+
+    if (recs[iRec].kind == TryCatchTraceKind_Site) {
+
+      iRec +=
+        (recs[iRec].thread + sizeof(struct TryCatchTraceRecord) - 1) /
+        sizeof(struct TryCatchTraceRecord);
+
+    } else if (recs[iRec].kind == TryCatchTraceKind_Raise) {
+
+      ProcessRaise(recs + iRec);
+
+    }
+
+  }
+
+  free(recs);
+  return true;
+
+}
+
+// Function to compare sites per decreasing number of raises, for qsort
+static int CmpSite(
+  void const* a,
+  void const* b) {
+
+  unsigned long nbA = ((struct Site const*)a)->nbRaise;
+  unsigned long nbB = ((struct Site const*)b)->nbRaise;
+  return (nbA < nbB) - (nbA > nbB);
+
+}
+
+// Main function
+int main(
+    int argc,
+  char** argv) {
+
+  // Process the options
+  int iArg = 1;
+  for (; iArg < argc && argv[iArg][0] == '-'; ++iArg) {
+
+    if (strcmp(argv[iArg], "-csv") == 0) {
+
+      optCsv = true;
+
+    } else if (strcmp(argv[iArg], "-top") == 0 && iArg + 1 < argc) {
+
+      optTop = strtoul(argv[++iArg], NULL, 10);
+
+    } else if (strcmp(argv[iArg], "-hist") == 0) {
+
+      optHist = true;
+
+    } else break;
+
+  }
+
+  if (iArg >= argc) {
+
+    fprintf(
+      stderr,
+      "Usage: trycatchcdecode [-csv] [-top <n>] [-hist] <file> ...\n");
+    return EXIT_FAILURE;
+
+  }
+
+  // Print the header of the CSV output
+  if (optCsv && optTop == 0 && optHist == false)
+    printf("timestamp,thread,exc,excName,file,line,level\n");
+
+  // Decode the files
+  int ret = EXIT_SUCCESS;
+  for (; iArg < argc; ++iArg)
+    if (DecodeFile(argv[iArg]) == false) ret = EXIT_FAILURE;
+
+  // Print the histogram
+  if (optHist) {
+
+    if (optCsv) printf("second,nbRaise\n");
+    for (
+      size_t iSecond = 0;
+      iSecond < nbSecond;
+      ++iSecond) {
+
+      printf(
+        (optCsv ? "%zu,%lu\n" : "%6zus %lu\n"),
+        iSecond,
+        histogram[iSecond]);
+
+    }
+
+  // Else, print the top sites
+  } else if (optTop > 0) {
+
+    qsort(
+      sites,
+      nbSite,
+      sizeof(struct Site),
+      CmpSite);
+    if (optCsv) printf("file,line,nbRaise\n");
+    for (
+      size_t iSite = 0;
+      iSite < nbSite && iSite < optTop && sites[iSite].nbRaise > 0;
+      ++iSite) {
+
+      printf(
+        (optCsv ? "\"%s\",%d,%lu\n" : "%s, line %d: %lu raises\n"),
+        sites[iSite].filename,
+        sites[iSite].line,
+        sites[iSite].nbRaise);
+
+    }
+
+  }
+
+  // Free memory
+  for (
+    size_t iSite = 0;
+    iSite < nbSite;
+    ++iSite) {
+
+    free(sites[iSite].filename);
+
+  }
+
+  free(sites);
+  free(histogram);
+  return ret;
+
+}
+
+// ------------------ trycatchcdecode.c ------------------
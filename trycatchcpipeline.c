@@ -0,0 +1,680 @@
+// ------------------ trycatchcpipeline.c ------------------
+
+// Include the header
+#include "trycatchcpipeline.h"
+
+// Include external modules header
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+
+// Number of consecutive empty polls of a stage before it sleeps instead
+// of yielding
+#ifndef TryCatchPipelineNbSpin
+#define TryCatchPipelineNbSpin 64
+#endif
+
+// Duration in nanoseconds of the sleep of an idle stage
+#ifndef TryCatchPipelineIdleSleep
+#define TryCatchPipelineIdleSleep 100000
+#endif
+
+// Size of a cache line, to keep the indices of the queues on separate
+// lines
+#define TryCatchPipelineCacheLine 64
+
+// Bounded lock-free single-producer single-consumer queue
+struct TryCatchPipelineQueue {
+
+  // Index of the next slot to read, written by the consumer only
+  _Alignas(TryCatchPipelineCacheLine) _Atomic size_t head;
+
+  // Index of the next slot to write, written by the producer only
+  _Alignas(TryCatchPipelineCacheLine) _Atomic size_t tail;
+
+  // Slots, and mask of the indices (capacity - 1)
+  _Alignas(TryCatchPipelineCacheLine) struct TryCatchDeadLetter* slots;
+  size_t mask;
+
+};
+
+// Stage of a pipeline
+struct TryCatchPipelineStage {
+
+  // Pipeline of the stage
+  struct TryCatchPipeline* pipeline;
+
+  // Index of the stage
+  int index;
+
+  // Function and argument of the stage
+  TryCatchPipelineFun fun;
+  void* arg;
+
+  // Input queue, shared with the previous stage or the pusher
+  struct TryCatchPipelineQueue* in;
+
+  // Output queue, shared with the next stage or the popper
+  struct TryCatchPipelineQueue* out;
+
+  // Dead-letter queue of the stage
+  struct TryCatchPipelineQueue dead;
+
+  // Thread of the stage
+  thrd_t thread;
+
+  // Flag to memorise if the thread of the stage has been started
+  bool isStarted;
+
+  // Flag to memorise if the stage has ended
+  _Atomic bool isDone;
+
+  // Counters of the stage
+  _Atomic uint64_t nbProcessed;
+  _Atomic uint64_t nbFailed;
+  _Atomic uint64_t nbStall;
+  _Atomic uint64_t busyTime;
+
+};
+
+// Pipeline
+struct TryCatchPipeline {
+
+  // Number of stages
+  int nbStage;
+
+  // Stages
+  struct TryCatchPipelineStage* stages;
+
+  // Queues between the stages, the first is the input of the pipeline
+  // and the last its output
+  struct TryCatchPipelineQueue* queues;
+
+  // Flag to memorise if the input is closed
+  _Atomic bool isClosed;
+
+  // Index of the next dead-letter queue to poll
+  int nextDead;
+
+};
+
+// Function to get the current time
+// Output:
+//   Return the time in nanoseconds
+static uint64_t TryCatchPipelineNow(
+  void) {
+
+  struct timespec ts;
+  timespec_get(
+    &ts,
+    TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+}
+
+// Function to wait in an idle loop, yielding first then sleeping
+// Input:
+//   nbIdle: The number of consecutive idle iterations so far
+static void TryCatchPipelineIdle(
+  unsigned int const nbIdle) {
+
+  if (nbIdle < TryCatchPipelineNbSpin) {
+
+    thrd_yield();
+
+  } else {
+
+    thrd_sleep(
+      &(struct timespec){.tv_sec = 0, .tv_nsec = TryCatchPipelineIdleSleep},
+      NULL);
+
+  }
+
+}
+
+// Function to initialise a queue
+// Inputs:
+//       that: The queue
+//   capacity: The capacity of the queue, a power of 2
+// Output:
+//   Return true if the queue could be initialised, else false
+static bool TryCatchPipelineQueueInit(
+  struct TryCatchPipelineQueue* const that,
+                         size_t const capacity) {
+
+  atomic_init(&(that->head), 0);
+  atomic_init(&(that->tail), 0);
+  that->mask = capacity - 1;
+  that->slots =
+    malloc(capacity * sizeof(struct TryCatchDeadLetter));
+  return that->slots != NULL;
+
+}
+
+// Function to push in a queue, without waiting
+// Inputs:
+//   that: The queue
+//   slot: The pushed slot
+// Output:
+//   Return true if the slot has been pushed, false if the queue is full
+static bool TryCatchPipelineQueuePush(
+       struct TryCatchPipelineQueue* const that,
+  struct TryCatchDeadLetter const* const slot) {
+
+  size_t tail =
+    atomic_load_explicit(
+      &(that->tail),
+      memory_order_relaxed);
+  size_t head =
+    atomic_load_explicit(
+      &(that->head),
+      memory_order_acquire);
+  if (tail - head > that->mask) return false;
+  that->slots[tail & that->mask] = *slot;
+  atomic_store_explicit(
+    &(that->tail),
+    tail + 1,
+    memory_order_release);
+  return true;
+
+}
+
+// Function to pop from a queue, without waiting
+// Inputs:
+//   that: The queue
+//   slot: Where to store the popped slot
+// Output:
+//   Return true if a slot has been popped, false if the queue is empty
+static bool TryCatchPipelineQueuePop(
+  struct TryCatchPipelineQueue* const that,
+     struct TryCatchDeadLetter* const slot) {
+
+  size_t head =
+    atomic_load_explicit(
+      &(that->head),
+      memory_order_relaxed);
+  size_t tail =
+    atomic_load_explicit(
+      &(that->tail),
+      memory_order_acquire);
+  if (head == tail) return false;
+  *slot = that->slots[head & that->mask];
+  atomic_store_explicit(
+    &(that->head),
+    head + 1,
+    memory_order_release);
+  return true;
+
+}
+
+// Function to check if a queue is empty
+// Input:
+//   that: The queue
+// Output:
+//   Return true if the queue is empty, else false
+static bool TryCatchPipelineQueueIsEmpty(
+  struct TryCatchPipelineQueue* const that) {
+
+  return atomic_load(&(that->head)) == atomic_load(&(that->tail));
+
+}
+
+// Function to push in a queue, waiting while the queue is full
+// Inputs:
+//    that: The queue
+//    slot: The pushed slot
+//   stage: The stage pushing, whose stalls are counted (can be NULL)
+static void TryCatchPipelineQueuePushWait(
+       struct TryCatchPipelineQueue* const that,
+  struct TryCatchDeadLetter const* const slot,
+       struct TryCatchPipelineStage* const stage) {
+
+  if (
+    TryCatchPipelineQueuePush(
+      that,
+      slot)) {
+
+    return;
+
+  }
+
+  if (stage != NULL) atomic_fetch_add(&(stage->nbStall), 1);
+  for (
+    unsigned int nbIdle = 0;
+    TryCatchPipelineQueuePush(
+      that,
+      slot) == false;
+    ++nbIdle) {
+
+    TryCatchPipelineIdle(nbIdle);
+
+  }
+
+}
+
+// Function to process an item in a stage inside a TryCatch block
+// Inputs:
+//    stage: The stage
+//     slot: The slot of the item, updated with the output item, or with
+//           the exception and its site if the processing has failed
+// Output:
+//   Return true if the item has been processed successfully, else false
+static bool TryCatchPipelineProcess(
+  struct TryCatchPipelineStage* const stage,
+     struct TryCatchDeadLetter* const slot) {
+
+  // The result is memorised in a volatile as it is modified after the
+  // setjmp
+  volatile bool isOk = true;
+  Try {
+
+    slot->item =
+      stage->fun(
+        slot->item,
+        stage->arg);
+
+  } CatchDefault {
+
+    isOk = false;
+    slot->exc = TryCatchGetLastExc();
+    slot->site = TryCatchGetLastSite();
+
+  } EndCatch;
+  return isOk;
+
+}
+
+// Main function of the thread of a stage, process the items of its input
+// queue until it is closed and empty
+// Input:
+//   arg: The stage
+// Output:
+//   Return 0
+static int TryCatchPipelineStageMain(
+  void* arg) {
+
+  struct TryCatchPipelineStage* stage = arg;
+  struct TryCatchPipeline* pipeline = stage->pipeline;
+  unsigned int nbIdle = 0;
+  for (;;) {
+
+    // The input is closed when the pipeline is closed for the first
+    // stage, else when the previous stage has ended. It's checked before
+    // polling the queue to not miss the last items.
+    bool isClosed =
+      (stage->index == 0 ?
+        atomic_load(&(pipeline->isClosed)) :
+        atomic_load(&(pipeline->stages[stage->index - 1].isDone)));
+    struct TryCatchDeadLetter slot;
+    if (
+      TryCatchPipelineQueuePop(
+        stage->in,
+        &slot) == false) {
+
+      if (isClosed) break;
+      TryCatchPipelineIdle(nbIdle);
+      ++nbIdle;
+      continue;
+
+    }
+
+    // Process the item, the original item is kept for the dead letter
+    nbIdle = 0;
+    void* item = slot.item;
+    uint64_t start = TryCatchPipelineNow();
+    bool isOk =
+      TryCatchPipelineProcess(
+        stage,
+        &slot);
+    atomic_fetch_add(
+      &(stage->busyTime),
+      TryCatchPipelineNow() - start);
+
+    // Pass the item to the next stage, or route it to the dead-letter
+    // queue
+    if (isOk) {
+
+      atomic_fetch_add(&(stage->nbProcessed), 1);
+      TryCatchPipelineQueuePushWait(
+        stage->out,
+        &slot,
+        stage);
+
+    } else {
+
+      atomic_fetch_add(&(stage->nbFailed), 1);
+      slot.item = item;
+      slot.stage = stage->index;
+      TryCatchPipelineQueuePushWait(
+        &(stage->dead),
+        &slot,
+        stage);
+
+    }
+
+  }
+
+  atomic_store(
+    &(stage->isDone),
+    true);
+  return 0;
+
+}
+
+// Function to create a pipeline and start the threads of its stages
+// Inputs:
+//     nbStage: The number of stages
+//        funs: The functions of the stages
+//        args: The arguments of the stages (can be NULL if all are NULL)
+//   queueSize: The capacity of the queues, rounded up to a power of 2
+// Output:
+//   Return the pipeline, or NULL if it couldn't be created
+struct TryCatchPipeline* TryCatchPipelineCreate(
+                       int const nbStage,
+  TryCatchPipelineFun const* const funs,
+               void* const* const args,
+                    size_t const queueSize) {
+
+  // Allocate memory for the pipeline
+  if (nbStage <= 0) return NULL;
+  struct TryCatchPipeline* that = malloc(sizeof(struct TryCatchPipeline));
+  if (that == NULL) return NULL;
+  that->nbStage = nbStage;
+  that->nextDead = 0;
+  atomic_init(&(that->isClosed), false);
+  that->stages =
+    aligned_alloc(
+      TryCatchPipelineCacheLine,
+      sizeof(struct TryCatchPipelineStage) * (size_t)nbStage);
+  that->queues =
+    aligned_alloc(
+      TryCatchPipelineCacheLine,
+      sizeof(struct TryCatchPipelineQueue) * (size_t)(nbStage + 1));
+  if (that->stages == NULL || that->queues == NULL) {
+
+    free(that->stages);
+    free(that->queues);
+    free(that);
+    return NULL;
+
+  }
+
+  // Get the capacity of the queues
+  size_t capacity = 1;
+  while (capacity < queueSize) capacity *= 2;
+
+  // Initialise the queues and the stages
+  bool isOk = true;
+  for (
+    int iQueue = 0;
+    iQueue <= nbStage;
+    ++iQueue) {
+
+    if (
+      TryCatchPipelineQueueInit(
+        that->queues + iQueue,
+        capacity) == false) {
+
+      isOk = false;
+
+    }
+
+  }
+
+  for (
+    int iStage = 0;
+    iStage < nbStage;
+    ++iStage) {
+
+    struct TryCatchPipelineStage* stage = that->stages + iStage;
+    stage->pipeline = that;
+    stage->index = iStage;
+    stage->fun = funs[iStage];
+    stage->arg = (args != NULL ? args[iStage] : NULL);
+    stage->in = that->queues + iStage;
+    stage->out = that->queues + iStage + 1;
+    stage->isStarted = false;
+    atomic_init(&(stage->isDone), false);
+    atomic_init(&(stage->nbProcessed), 0);
+    atomic_init(&(stage->nbFailed), 0);
+    atomic_init(&(stage->nbStall), 0);
+    atomic_init(&(stage->busyTime), 0);
+    if (
+      TryCatchPipelineQueueInit(
+        &(stage->dead),
+        capacity) == false) {
+
+      isOk = false;
+
+    }
+
+  }
+
+  // Start the threads of the stages
+  for (
+    int iStage = 0;
+    iStage < nbStage && isOk;
+    ++iStage) {
+
+    struct TryCatchPipelineStage* stage = that->stages + iStage;
+    isOk =
+      thrd_create(
+        &(stage->thread),
+        TryCatchPipelineStageMain,
+        stage) == thrd_success;
+    stage->isStarted = isOk;
+
+  }
+
+  if (isOk == false) TryCatchPipelineFree(&that);
+  return that;
+
+}
+
+// Function to free a pipeline. The input is closed, and the function
+// waits for the stages to end, so the output and dead-letter queues must
+// have been consumed.
+// Input:
+//   that: The pipeline, set to NULL on return
+void TryCatchPipelineFree(
+  struct TryCatchPipeline** const that) {
+
+  if (that == NULL || *that == NULL) return;
+
+  // Close the input and wait for the stages. If a stage couldn't be
+  // started, the following ones never see their input closed: flag it
+  // as ended.
+  TryCatchPipelineClose(*that);
+  for (
+    int iStage = 0;
+    iStage < (*that)->nbStage;
+    ++iStage) {
+
+    struct TryCatchPipelineStage* stage = (*that)->stages + iStage;
+    if (stage->isStarted)
+      thrd_join(
+        stage->thread,
+        NULL);
+    else
+      atomic_store(
+        &(stage->isDone),
+        true);
+
+  }
+
+  // Free memory
+  for (
+    int iStage = 0;
+    iStage < (*that)->nbStage;
+    ++iStage) {
+
+    free((*that)->stages[iStage].dead.slots);
+
+  }
+
+  for (
+    int iQueue = 0;
+    iQueue <= (*that)->nbStage;
+    ++iQueue) {
+
+    free((*that)->queues[iQueue].slots);
+
+  }
+
+  free((*that)->stages);
+  free((*that)->queues);
+  free(*that);
+  *that = NULL;
+
+}
+
+// Function to push an item at the input of a pipeline, waiting while the
+// input queue is full. To be called by one thread only.
+// Inputs:
+//   that: The pipeline
+//   item: The item
+void TryCatchPipelinePush(
+  struct TryCatchPipeline* const that,
+                    void* const item) {
+
+  struct TryCatchDeadLetter slot = {
+    .item = item,
+    .stage = 0,
+    .exc = 0,
+    .site = NULL
+  };
+  TryCatchPipelineQueuePushWait(
+    that->queues,
+    &slot,
+    NULL);
+
+}
+
+// Function to close the input of a pipeline, the stages end after
+// processing the items already pushed
+// Input:
+//   that: The pipeline
+void TryCatchPipelineClose(
+  struct TryCatchPipeline* const that) {
+
+  atomic_store(
+    &(that->isClosed),
+    true);
+
+}
+
+// Function to pop an item at the output of a pipeline, without waiting.
+// To be called by one thread only.
+// Inputs:
+//   that: The pipeline
+//   item: Where to store the item
+// Output:
+//   Return true if an item has been popped, else false
+bool TryCatchPipelinePop(
+  struct TryCatchPipeline* const that,
+                   void** const item) {
+
+  struct TryCatchDeadLetter slot;
+  if (
+    TryCatchPipelineQueuePop(
+      that->queues + that->nbStage,
+      &slot) == false) {
+
+    return false;
+
+  }
+
+  *item = slot.item;
+  return true;
+
+}
+
+// Function to pop an item from the dead-letter queues of a pipeline,
+// without waiting. To be called by one thread only.
+// Inputs:
+//     that: The pipeline
+//   letter: Where to store the item and its failure
+// Output:
+//   Return true if an item has been popped, else false
+bool TryCatchPipelinePopDeadLetter(
+  struct TryCatchPipeline* const that,
+  struct TryCatchDeadLetter* const letter) {
+
+  // Poll the dead-letter queues in turn, to not starve any stage
+  for (
+    int iStage = 0;
+    iStage < that->nbStage;
+    ++iStage) {
+
+    struct TryCatchPipelineStage* stage = that->stages + that->nextDead;
+    that->nextDead = (that->nextDead + 1) % that->nbStage;
+    if (
+      TryCatchPipelineQueuePop(
+        &(stage->dead),
+        letter)) {
+
+      return true;
+
+    }
+
+  }
+
+  return false;
+
+}
+
+// Function to check if a pipeline has ended: its input is closed, all
+// the stages have ended and the output and dead-letter queues are empty
+// Input:
+//   that: The pipeline
+// Output:
+//   Return true if the pipeline has ended, else false
+bool TryCatchPipelineIsDone(
+  struct TryCatchPipeline* const that) {
+
+  // The stages are checked before the queues, as an ended stage doesn't
+  // push anymore
+  for (
+    int iStage = 0;
+    iStage < that->nbStage;
+    ++iStage) {
+
+    if (atomic_load(&(that->stages[iStage].isDone)) == false) return false;
+
+  }
+
+  for (
+    int iStage = 0;
+    iStage < that->nbStage;
+    ++iStage) {
+
+    if (TryCatchPipelineQueueIsEmpty(&(that->stages[iStage].dead)) == false)
+      return false;
+
+  }
+
+  return TryCatchPipelineQueueIsEmpty(that->queues + that->nbStage);
+
+}
+
+// Function to get the counters of a stage of a pipeline
+// Inputs:
+//    that: The pipeline
+//   stage: The index of the stage
+// Output:
+//   Return a snapshot of the counters
+struct TryCatchPipelineStats TryCatchPipelineGetStats(
+  struct TryCatchPipeline* const that,
+                      int const stage) {
+
+  struct TryCatchPipelineStage* ptr = that->stages + stage;
+  return (struct TryCatchPipelineStats){
+    .nbProcessed = atomic_load(&(ptr->nbProcessed)),
+    .nbFailed = atomic_load(&(ptr->nbFailed)),
+    .nbStall = atomic_load(&(ptr->nbStall)),
+    .busyTime = atomic_load(&(ptr->busyTime))
+  };
+
+}
+
+// ------------------ trycatchcpipeline.c ------------------
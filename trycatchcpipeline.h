@@ -0,0 +1,149 @@
+// ------------------ trycatchcpipeline.h ------------------
+
+// Guard against multiple inclusions
+#ifndef TryCATCHCPIPELINE_H
+#define TryCATCHCPIPELINE_H
+
+// Include external modules header
+#include <stdlib.h>
+#include <stdint.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Pipeline running a chain of stages, each on its own thread, connected
+// by bounded lock-free single-producer single-consumer queues. Each item
+// is processed by a stage inside its own TryCatch block: an item whose
+// processing raises an exception is routed to the dead-letter queue of
+// the stage, tagged with the exception and its site, and the pipeline
+// keeps flowing. A stage whose output queue is full waits for it to be
+// consumed (backpressure).
+struct TryCatchPipeline;
+
+// Function processing an item in a stage of a pipeline
+// Inputs:
+//   item: The item
+//    arg: The argument of the stage
+// Output:
+//   Return the item passed to the next stage
+typedef void* (*TryCatchPipelineFun)(
+  void* item,
+  void* arg);
+
+// Item routed to a dead-letter queue
+struct TryCatchDeadLetter {
+
+  // Item, as it was given to the stage
+  void* item;
+
+  // Index of the stage which raised the exception
+  int stage;
+
+  // Raised exception
+  int exc;
+
+  // Site of the raise (NULL if unknown)
+  struct TryCatchSite const* site;
+
+};
+
+// Snapshot of the counters of a stage
+struct TryCatchPipelineStats {
+
+  // Number of items processed successfully
+  uint64_t nbProcessed;
+
+  // Number of items routed to the dead-letter queue
+  uint64_t nbFailed;
+
+  // Number of times the stage has waited for a full queue
+  uint64_t nbStall;
+
+  // Time spent processing items, in nanoseconds
+  uint64_t busyTime;
+
+};
+
+// Function to create a pipeline and start the threads of its stages
+// Inputs:
+//     nbStage: The number of stages
+//        funs: The functions of the stages
+//        args: The arguments of the stages (can be NULL if all are NULL)
+//   queueSize: The capacity of the queues, rounded up to a power of 2
+// Output:
+//   Return the pipeline, or NULL if it couldn't be created
+struct TryCatchPipeline* TryCatchPipelineCreate(
+                       int const nbStage,
+  TryCatchPipelineFun const* const funs,
+               void* const* const args,
+                    size_t const queueSize);
+
+// Function to free a pipeline. The input is closed, and the function
+// waits for the stages to end, so the output and dead-letter queues must
+// have been consumed.
+// Input:
+//   that: The pipeline, set to NULL on return
+void TryCatchPipelineFree(
+  struct TryCatchPipeline** const that);
+
+// Function to push an item at the input of a pipeline, waiting while the
+// input queue is full. To be called by one thread only.
+// Inputs:
+//   that: The pipeline
+//   item: The item
+void TryCatchPipelinePush(
+  struct TryCatchPipeline* const that,
+                    void* const item);
+
+// Function to close the input of a pipeline, the stages end after
+// processing the items already pushed
+// Input:
+//   that: The pipeline
+void TryCatchPipelineClose(
+  struct TryCatchPipeline* const that);
+
+// Function to pop an item at the output of a pipeline, without waiting.
+// To be called by one thread only.
+// Inputs:
+//   that: The pipeline
+//   item: Where to store the item
+// Output:
+//   Return true if an item has been popped, else false
+bool TryCatchPipelinePop(
+  struct TryCatchPipeline* const that,
+                   void** const item);
+
+// Function to pop an item from the dead-letter queues of a pipeline,
+// without waiting. To be called by one thread only.
+// Inputs:
+//     that: The pipeline
+//   letter: Where to store the item and its failure
+// Output:
+//   Return true if an item has been popped, else false
+bool TryCatchPipelinePopDeadLetter(
+  struct TryCatchPipeline* const that,
+  struct TryCatchDeadLetter* const letter);
+
+// Function to check if a pipeline has ended: its input is closed, all
+// the stages have ended and the output and dead-letter queues are empty
+// Input:
+//   that: The pipeline
+// Output:
+//   Return true if the pipeline has ended, else false
+bool TryCatchPipelineIsDone(
+  struct TryCatchPipeline* const that);
+
+// Function to get the counters of a stage of a pipeline
+// Inputs:
+//    that: The pipeline
+//   stage: The index of the stage
+// Output:
+//   Return a snapshot of the counters
+struct TryCatchPipelineStats TryCatchPipelineGetStats(
+  struct TryCatchPipeline* const that,
+                      int const stage);
+
+// End of the guard against multiple inclusion
+#endif
+
+// ------------------ trycatchcpipeline.h ------------------
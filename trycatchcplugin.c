@@ -0,0 +1,551 @@
+// ------------------ trycatchcplugin.c ------------------
+
+// The host relies on dlopen, POSIX read-write locks and clocks which are
+// not defined in ANSI C, request their declaration
+#define _GNU_SOURCE
+
+// Include the header
+#include "trycatchcplugin.h"
+
+// Include external modules header
+#include <stdatomic.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#include <time.h>
+
+// Max number of plugins in a host
+#ifndef TryCatchPluginMaxNb
+#define TryCatchPluginMaxNb 64
+#endif
+
+// Name of the optional initialisation function of the plugins
+#define TryCatchPluginInitName "TryCatchPluginInit"
+
+// Plugin loaded in a host
+struct TryCatchPlugin {
+
+  // Host of the plugin
+  struct TryCatchPluginHost* host;
+
+  // Path and name of the entry point of the plugin, to reload it
+  char* path;
+  char* entryName;
+
+  // Handle of the plugin and its entry point, NULL if it couldn't be
+  // reloaded
+  void* handle;
+  TryCatchPluginFun entry;
+
+  // First exception ID of the range of the plugin
+  int excBase;
+
+  // Lock read-locked by the calls and write-locked by the reload, which
+  // then waits for the calls in flight to end
+  pthread_rwlock_t lock;
+
+  // Flag to memorise if the plugin is quarantined
+  _Atomic bool isQuarantined;
+
+  // Number of faults since the plugin has been (re)loaded
+  _Atomic int nbFault;
+
+  // Counters of the plugin
+  _Atomic uint64_t nbCall;
+  _Atomic uint64_t nbExc;
+  _Atomic uint64_t nbRejected;
+  _Atomic uint64_t nbReload;
+  _Atomic uint64_t busyTime;
+  _Atomic uint64_t maxTime;
+  _Atomic int lastExc;
+
+};
+
+// Host of plugins
+struct TryCatchPluginHost {
+
+  // First exception ID of the range of the plugins
+  int excBase;
+
+  // Number of faults after which a plugin is quarantined
+  int maxFault;
+
+  // Plugins, in their order of loading, the index of a plugin gives its
+  // range of exception IDs
+  struct TryCatchPlugin* plugins[TryCatchPluginMaxNb];
+  _Atomic int nbPlugin;
+
+};
+
+// Function to get the current time
+// Output:
+//   Return the time in nanoseconds
+static uint64_t TryCatchPluginNow(
+  void) {
+
+  struct timespec ts;
+  clock_gettime(
+    CLOCK_MONOTONIC,
+    &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+}
+
+// Range of memory where a plugin is mapped
+struct TryCatchPluginRange {
+
+  // Load address of the plugin
+  uintptr_t base;
+
+  // Start and end (excluded) addresses of its loaded segments
+  uintptr_t start;
+  uintptr_t end;
+
+};
+
+// Function called by dl_iterate_phdr on each loaded object to get the
+// range of memory of a plugin
+// Inputs:
+//   info: Info about the loaded object
+//   size: The size of info, unused
+//   data: The range, its base selects the plugin
+// Output:
+//   Return 1 to stop the iteration once the plugin has been found, else 0
+static int TryCatchPluginGetRange(
+  struct dl_phdr_info* info,
+                size_t size,
+                 void* data) {
+
+  // Unused parameter
+  (void)size;
+
+  struct TryCatchPluginRange* range = data;
+  if (info->dlpi_addr != range->base) return 0;
+  for (
+    int iHdr = 0;
+    iHdr < info->dlpi_phnum;
+    ++iHdr) {
+
+    ElfW(Phdr) const* hdr = info->dlpi_phdr + iHdr;
+    if (hdr->p_type != PT_LOAD) continue;
+    uintptr_t start = info->dlpi_addr + hdr->p_vaddr;
+    uintptr_t end = start + hdr->p_memsz;
+    if (start < range->start) range->start = start;
+    if (end > range->end) range->end = end;
+
+  }
+
+  return 1;
+
+}
+
+// Function to close a plugin. Its raise sites are forgotten before it's
+// unmapped, the descriptors of those referenced by TryCatchC are replaced
+// by copies and their indices are given back to the plugin if it's
+// loaded again.
+// Input:
+//   that: The plugin, its handle and entry point are reset
+static void TryCatchPluginClose(
+  struct TryCatchPlugin* const that) {
+
+  struct link_map* map = NULL;
+  if (
+    dlinfo(
+      that->handle,
+      RTLD_DI_LINKMAP,
+      &map) == 0 &&
+    map != NULL) {
+
+    struct TryCatchPluginRange range = {
+      .base = map->l_addr,
+      .start = UINTPTR_MAX,
+      .end = 0};
+    dl_iterate_phdr(
+      TryCatchPluginGetRange,
+      &range);
+    if (range.start < range.end)
+      TryCatchForgetSites(
+        (void const*)range.start,
+        range.end - range.start);
+
+  }
+
+  dlclose(that->handle);
+  that->handle = NULL;
+  that->entry = NULL;
+
+}
+
+// Function to open a plugin, get its entry point and initialise it
+// Input:
+//   that: The plugin, its handle and entry point are updated
+// Output:
+//   Return true if the plugin could be opened, else false
+static bool TryCatchPluginOpen(
+  struct TryCatchPlugin* const that) {
+
+  that->handle =
+    dlopen(
+      that->path,
+      RTLD_NOW | RTLD_LOCAL);
+  if (that->handle == NULL) return false;
+
+  // The symbols are converted to pointers to functions with memcpy, ISO C
+  // doesn't allow the cast from void*
+  void* sym =
+    dlsym(
+      that->handle,
+      that->entryName);
+  void* init =
+    dlsym(
+      that->handle,
+      TryCatchPluginInitName);
+  memcpy(
+    &(that->entry),
+    &sym,
+    sizeof(void*));
+
+  // Give its range of exception IDs to the plugin
+  volatile bool isOk = (sym != NULL);
+  if (isOk && init != NULL) {
+
+    void (*initFun)(int);
+    memcpy(
+      &initFun,
+      &init,
+      sizeof(void*));
+    int lvl = TryCatchGetLevel();
+    Try {
+
+      initFun(that->excBase);
+      TryCatchRestoreLevel(lvl + 1);
+
+    } CatchDefault {
+
+      isOk = false;
+
+    } EndCatch;
+
+  }
+
+  if (isOk == false) TryCatchPluginClose(that);
+
+  return isOk;
+
+}
+
+// Function to create a host of plugins
+// Inputs:
+//    excBase: The first exception ID of the range of the plugins, each
+//             plugin owns the next TryCatchPluginNbExc IDs
+//   maxFault: The number of faults after which a plugin is quarantined
+// Output:
+//   Return the host, or NULL if it couldn't be created
+struct TryCatchPluginHost* TryCatchPluginHostCreate(
+  int const excBase,
+  int const maxFault) {
+
+  struct TryCatchPluginHost* that = malloc(sizeof(struct TryCatchPluginHost));
+  if (that == NULL) return NULL;
+  that->excBase = excBase;
+  that->maxFault = maxFault;
+  atomic_init(&(that->nbPlugin), 0);
+  return that;
+
+}
+
+// Function to free a host and unload its plugins, once there is no call
+// in flight
+// Input:
+//   that: The host, set to NULL on return
+void TryCatchPluginHostFree(
+  struct TryCatchPluginHost** const that) {
+
+  if (that == NULL || *that == NULL) return;
+  int nbPlugin = atomic_load(&((*that)->nbPlugin));
+  for (
+    int iPlugin = 0;
+    iPlugin < nbPlugin;
+    ++iPlugin) {
+
+    struct TryCatchPlugin* plugin = (*that)->plugins[iPlugin];
+    if (plugin->handle != NULL) TryCatchPluginClose(plugin);
+    pthread_rwlock_destroy(&(plugin->lock));
+    free(plugin->path);
+    free(plugin->entryName);
+    free(plugin);
+
+  }
+
+  free(*that);
+  *that = NULL;
+
+}
+
+// Function to load a plugin in a host
+// Inputs:
+//    that: The host
+//    path: The path of the plugin, as given to dlopen
+//   entry: The name of the entry point of the plugin
+// Output:
+//   Return the plugin, or NULL if it couldn't be loaded, its entry point
+//   wasn't found, its initialisation has failed or there are already
+//   TryCatchPluginMaxNb plugins
+struct TryCatchPlugin* TryCatchPluginLoad(
+  struct TryCatchPluginHost* const that,
+                 char const* const path,
+                 char const* const entry) {
+
+  // Allocate memory for the plugin
+  int iPlugin = atomic_load(&(that->nbPlugin));
+  if (iPlugin >= TryCatchPluginMaxNb) return NULL;
+  struct TryCatchPlugin* plugin = malloc(sizeof(struct TryCatchPlugin));
+  if (plugin == NULL) return NULL;
+  *plugin = (struct TryCatchPlugin){
+    .host = that,
+    .path = malloc(strlen(path) + 1),
+    .entryName = malloc(strlen(entry) + 1),
+    .handle = NULL,
+    .entry = NULL,
+    .excBase = that->excBase + iPlugin * TryCatchPluginNbExc
+  };
+  if (
+    plugin->path == NULL ||
+    plugin->entryName == NULL ||
+    pthread_rwlock_init(
+      &(plugin->lock),
+      NULL) != 0) {
+
+    free(plugin->path);
+    free(plugin->entryName);
+    free(plugin);
+    return NULL;
+
+  }
+
+  strcpy(
+    plugin->path,
+    path);
+  strcpy(
+    plugin->entryName,
+    entry);
+  atomic_init(&(plugin->isQuarantined), false);
+  atomic_init(&(plugin->nbFault), 0);
+  atomic_init(&(plugin->nbCall), 0);
+  atomic_init(&(plugin->nbExc), 0);
+  atomic_init(&(plugin->nbRejected), 0);
+  atomic_init(&(plugin->nbReload), 0);
+  atomic_init(&(plugin->busyTime), 0);
+  atomic_init(&(plugin->maxTime), 0);
+  atomic_init(&(plugin->lastExc), 0);
+
+  // Open the plugin
+  if (TryCatchPluginOpen(plugin) == false) {
+
+    pthread_rwlock_destroy(&(plugin->lock));
+    free(plugin->path);
+    free(plugin->entryName);
+    free(plugin);
+    return NULL;
+
+  }
+
+  // Add the plugin to the host
+  that->plugins[iPlugin] = plugin;
+  atomic_store(
+    &(that->nbPlugin),
+    iPlugin + 1);
+  return plugin;
+
+}
+
+// Function to call the entry point of a plugin in its own TryCatch block,
+// can be called by several threads at the same time
+// Inputs:
+//   that: The plugin
+//    arg: The argument of the call
+// Output:
+//   Return 0 if the entry point has returned, else the exception it has
+//   raised, or TryCatchExc_CircuitOpen if the plugin is quarantined
+int TryCatchPluginCall(
+  struct TryCatchPlugin* const that,
+                  void* const arg) {
+
+  // Reject the call if the plugin is quarantined, checked again once
+  // the lock is acquired as the quarantine may have been decided meanwhile
+  if (atomic_load(&(that->isQuarantined))) {
+
+    atomic_fetch_add(&(that->nbRejected), 1);
+    return TryCatchExc_CircuitOpen;
+
+  }
+
+  pthread_rwlock_rdlock(&(that->lock));
+  if (atomic_load(&(that->isQuarantined)) || that->entry == NULL) {
+
+    pthread_rwlock_unlock(&(that->lock));
+    atomic_fetch_add(&(that->nbRejected), 1);
+    return TryCatchExc_CircuitOpen;
+
+  }
+
+  // Call the entry point, the exception is memorised in a volatile as it
+  // is modified after the setjmp
+  volatile int exc = 0;
+  uint64_t start = TryCatchPluginNow();
+  int lvl = TryCatchGetLevel();
+  Try {
+
+    that->entry(arg);
+
+    // End the blocks the entry point may have left open, for EndCatch to
+    // end the block of the call
+    TryCatchRestoreLevel(lvl + 1);
+
+  } CatchDefault {
+
+    exc = TryCatchGetLastExc();
+
+  } EndCatch;
+
+  // Update the counters
+  uint64_t elapsed = TryCatchPluginNow() - start;
+  atomic_fetch_add(&(that->nbCall), 1);
+  atomic_fetch_add(
+    &(that->busyTime),
+    elapsed);
+  uint64_t maxTime = atomic_load(&(that->maxTime));
+  while (
+    elapsed > maxTime &&
+    atomic_compare_exchange_weak(
+      &(that->maxTime),
+      &maxTime,
+      elapsed) == false);
+
+  // Quarantine the plugin after too many faults
+  if (exc != 0) {
+
+    atomic_fetch_add(&(that->nbExc), 1);
+    atomic_store(
+      &(that->lastExc),
+      exc);
+    if (atomic_fetch_add(&(that->nbFault), 1) + 1 >= that->host->maxFault)
+      atomic_store(
+        &(that->isQuarantined),
+        true);
+
+  }
+
+  pthread_rwlock_unlock(&(that->lock));
+  return exc;
+
+}
+
+// Function to reload the quarantined plugins of a host, waiting for their
+// calls in flight to end. A plugin which can't be reloaded stays
+// quarantined. The other plugins can be called during the reload.
+// Input:
+//   that: The host
+// Output:
+//   Return the number of reloaded plugins
+int TryCatchPluginHostReload(
+  struct TryCatchPluginHost* const that) {
+
+  int nbReload = 0;
+  int nbPlugin = atomic_load(&(that->nbPlugin));
+  for (
+    int iPlugin = 0;
+    iPlugin < nbPlugin;
+    ++iPlugin) {
+
+    struct TryCatchPlugin* plugin = that->plugins[iPlugin];
+    if (atomic_load(&(plugin->isQuarantined)) == false) continue;
+
+    // Wait for the calls in flight, then unload and reload the plugin
+    pthread_rwlock_wrlock(&(plugin->lock));
+    if (plugin->handle != NULL) TryCatchPluginClose(plugin);
+
+    if (TryCatchPluginOpen(plugin)) {
+
+      atomic_store(
+        &(plugin->nbFault),
+        0);
+      atomic_fetch_add(&(plugin->nbReload), 1);
+      atomic_store(
+        &(plugin->isQuarantined),
+        false);
+      ++nbReload;
+
+    }
+
+    pthread_rwlock_unlock(&(plugin->lock));
+
+  }
+
+  return nbReload;
+
+}
+
+// Function to check if a plugin is quarantined
+// Input:
+//   that: The plugin
+// Output:
+//   Return true if the plugin is quarantined, else false
+bool TryCatchPluginIsQuarantined(
+  struct TryCatchPlugin const* const that) {
+
+  return atomic_load(&(that->isQuarantined));
+
+}
+
+// Function to get the first exception ID of the range of a plugin
+// Input:
+//   that: The plugin
+// Output:
+//   Return the exception ID
+int TryCatchPluginGetExcBase(
+  struct TryCatchPlugin const* const that) {
+
+  return that->excBase;
+
+}
+
+// Function to get the plugin owning an exception ID
+// Inputs:
+//   that: The host
+//    exc: The exception ID
+// Output:
+//   Return the plugin, or NULL if the exception isn't owned by a plugin
+struct TryCatchPlugin* TryCatchPluginGetExcOwner(
+  struct TryCatchPluginHost* const that,
+                         int const exc) {
+
+  if (exc < that->excBase) return NULL;
+  int iPlugin = (exc - that->excBase) / TryCatchPluginNbExc;
+  if (iPlugin >= atomic_load(&(that->nbPlugin))) return NULL;
+  return that->plugins[iPlugin];
+
+}
+
+// Function to get the counters of a plugin
+// Input:
+//   that: The plugin
+// Output:
+//   Return a snapshot of the counters
+struct TryCatchPluginStats TryCatchPluginGetStats(
+  struct TryCatchPlugin const* const that) {
+
+  return (struct TryCatchPluginStats){
+    .nbCall = atomic_load(&(that->nbCall)),
+    .nbExc = atomic_load(&(that->nbExc)),
+    .nbRejected = atomic_load(&(that->nbRejected)),
+    .nbReload = atomic_load(&(that->nbReload)),
+    .busyTime = atomic_load(&(that->busyTime)),
+    .maxTime = atomic_load(&(that->maxTime)),
+    .lastExc = atomic_load(&(that->lastExc))
+  };
+
+}
+
+// ------------------ trycatchcplugin.c ------------------
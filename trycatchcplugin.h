@@ -0,0 +1,161 @@
+// ------------------ trycatchcplugin.h ------------------
+
+// Guard against multiple inclusions
+#ifndef TryCATCHCPLUGIN_H
+#define TryCATCHCPLUGIN_H
+
+// Include external modules header
+#include <stdlib.h>
+#include <stdint.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Host of plugins loaded with dlopen. The entry point of a plugin is
+// called in its own TryCatch block: an exception it doesn't catch is
+// returned to the caller and counted as a fault of the plugin. Each
+// plugin owns a range of TryCatchPluginNbExc exception IDs, given at its
+// loading to its optional function 'void TryCatchPluginInit(int
+// excBase)', to raise its own exceptions without conflict with the other
+// plugins. After maxFault faults the plugin is quarantined: the new calls
+// are rejected, and TryCatchPluginHostReload waits for the calls in
+// flight to end, then unloads and reloads the plugin in place while the
+// other plugins keep running. A segmentation fault in a plugin is caught
+// as TryCatchExc_Segv if TryCatchInitHandlerSigSegv() has been called.
+// The plugins raise their exceptions with the TryCatchC of the host, which
+// must be linked to the shared library or export its symbols (-rdynamic).
+// The raise sites of a plugin are forgotten (cf. TryCatchForgetSites)
+// before it's unloaded, their indices are given back to the plugin when
+// it's reloaded. The host relies on dlopen and is a POSIX feature.
+struct TryCatchPluginHost;
+
+// Plugin loaded in a host
+struct TryCatchPlugin;
+
+// Number of exception IDs owned by each plugin
+#ifndef TryCatchPluginNbExc
+#define TryCatchPluginNbExc 256
+#endif
+
+// Entry point of a plugin
+// Input:
+//   arg: The argument of the call
+typedef void (*TryCatchPluginFun)(
+  void* arg);
+
+// Snapshot of the counters of a plugin
+struct TryCatchPluginStats {
+
+  // Number of calls of the entry point
+  uint64_t nbCall;
+
+  // Number of calls ended by an exception
+  uint64_t nbExc;
+
+  // Number of calls rejected while the plugin was quarantined
+  uint64_t nbRejected;
+
+  // Number of reloads
+  uint64_t nbReload;
+
+  // Time spent in the entry point, and longest call, in nanoseconds
+  uint64_t busyTime;
+  uint64_t maxTime;
+
+  // Last exception raised by the entry point (0 if none)
+  int lastExc;
+
+};
+
+// Function to create a host of plugins
+// Inputs:
+//    excBase: The first exception ID of the range of the plugins, each
+//             plugin owns the next TryCatchPluginNbExc IDs
+//   maxFault: The number of faults after which a plugin is quarantined
+// Output:
+//   Return the host, or NULL if it couldn't be created
+struct TryCatchPluginHost* TryCatchPluginHostCreate(
+  int const excBase,
+  int const maxFault);
+
+// Function to free a host and unload its plugins, once there is no call
+// in flight
+// Input:
+//   that: The host, set to NULL on return
+void TryCatchPluginHostFree(
+  struct TryCatchPluginHost** const that);
+
+// Function to load a plugin in a host
+// Inputs:
+//    that: The host
+//    path: The path of the plugin, as given to dlopen
+//   entry: The name of the entry point of the plugin
+// Output:
+//   Return the plugin, or NULL if it couldn't be loaded, its entry point
+//   wasn't found, its initialisation has failed or there are already
+//   TryCatchPluginMaxNb plugins
+struct TryCatchPlugin* TryCatchPluginLoad(
+  struct TryCatchPluginHost* const that,
+                 char const* const path,
+                 char const* const entry);
+
+// Function to call the entry point of a plugin in its own TryCatch block,
+// can be called by several threads at the same time
+// Inputs:
+//   that: The plugin
+//    arg: The argument of the call
+// Output:
+//   Return 0 if the entry point has returned, else the exception it has
+//   raised, or TryCatchExc_CircuitOpen if the plugin is quarantined
+int TryCatchPluginCall(
+  struct TryCatchPlugin* const that,
+                  void* const arg);
+
+// Function to reload the quarantined plugins of a host, waiting for their
+// calls in flight to end. A plugin which can't be reloaded stays
+// quarantined. The other plugins can be called during the reload.
+// Input:
+//   that: The host
+// Output:
+//   Return the number of reloaded plugins
+int TryCatchPluginHostReload(
+  struct TryCatchPluginHost* const that);
+
+// Function to check if a plugin is quarantined
+// Input:
+//   that: The plugin
+// Output:
+//   Return true if the plugin is quarantined, else false
+bool TryCatchPluginIsQuarantined(
+  struct TryCatchPlugin const* const that);
+
+// Function to get the first exception ID of the range of a plugin
+// Input:
+//   that: The plugin
+// Output:
+//   Return the exception ID
+int TryCatchPluginGetExcBase(
+  struct TryCatchPlugin const* const that);
+
+// Function to get the plugin owning an exception ID
+// Inputs:
+//   that: The host
+//    exc: The exception ID
+// Output:
+//   Return the plugin, or NULL if the exception isn't owned by a plugin
+struct TryCatchPlugin* TryCatchPluginGetExcOwner(
+  struct TryCatchPluginHost* const that,
+                         int const exc);
+
+// Function to get the counters of a plugin
+// Input:
+//   that: The plugin
+// Output:
+//   Return a snapshot of the counters
+struct TryCatchPluginStats TryCatchPluginGetStats(
+  struct TryCatchPlugin const* const that);
+
+// End of the guard against multiple inclusion
+#endif
+
+// ------------------ trycatchcplugin.h ------------------
@@ -0,0 +1,349 @@
+// ------------------ trycatchcreactor.c ------------------
+
+// The reactor relies on epoll which is not defined in ANSI C, request its
+// declaration
+#define _GNU_SOURCE
+
+// Include the header
+#include "trycatchcreactor.h"
+
+// Include external modules header
+#include <errno.h>
+#include <unistd.h>
+
+// Max number of events dispatched per call to TryCatchReactorRun
+#ifndef TryCatchReactorMaxNbEvent
+#define TryCatchReactorMaxNbEvent 64
+#endif
+
+// Connection registered in a reactor
+struct TryCatchReactorConn {
+
+  // File descriptor of the connection
+  int fd;
+
+  // Callbacks of the connection
+  TryCatchReactorFun onEvt;
+  TryCatchReactorErrorFun onErr;
+
+  // User data of the connection
+  void* data;
+
+  // Number of exceptions raised and not caught by the callbacks
+  uint64_t nbExc;
+
+  // Flag to memorise if the connection has been removed
+  bool isRemoved;
+
+  // Next connection in the list of the reactor
+  struct TryCatchReactorConn* next;
+
+};
+
+// Reactor
+struct TryCatchReactor {
+
+  // File descriptor of the epoll instance
+  int epollFd;
+
+  // List of the connections
+  struct TryCatchReactorConn* conns;
+
+  // Flag to memorise if the reactor is dispatching events, during which
+  // the removed connections are freed only at the end of the dispatch
+  bool isDispatching;
+
+};
+
+// Function to create a reactor
+// Output:
+//   Return the reactor, or NULL if it couldn't be created
+struct TryCatchReactor* TryCatchReactorCreate(
+  void) {
+
+  struct TryCatchReactor* that = malloc(sizeof(struct TryCatchReactor));
+  if (that == NULL) return NULL;
+  that->epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (that->epollFd < 0) {
+
+    free(that);
+    return NULL;
+
+  }
+
+  that->conns = NULL;
+  that->isDispatching = false;
+  return that;
+
+}
+
+// Function to free the removed connections of a reactor
+// Input:
+//   that: The reactor
+static void TryCatchReactorPurge(
+  struct TryCatchReactor* const that) {
+
+  struct TryCatchReactorConn** ptr = &(that->conns);
+  while (*ptr != NULL) {
+
+    if ((*ptr)->isRemoved) {
+
+      struct TryCatchReactorConn* conn = *ptr;
+      *ptr = conn->next;
+      free(conn);
+
+    } else ptr = &((*ptr)->next);
+
+  }
+
+}
+
+// Function to free a reactor and its connections. The file descriptors
+// of the connections are not closed.
+// Input:
+//   that: The reactor, set to NULL on return
+void TryCatchReactorFree(
+  struct TryCatchReactor** const that) {
+
+  if (that == NULL || *that == NULL) return;
+  for (
+    struct TryCatchReactorConn* conn = (*that)->conns;
+    conn != NULL;
+    conn = conn->next) {
+
+    conn->isRemoved = true;
+
+  }
+
+  TryCatchReactorPurge(*that);
+  close((*that)->epollFd);
+  free(*that);
+  *that = NULL;
+
+}
+
+// Function to add a connection to a reactor
+// Inputs:
+//      that: The reactor
+//        fd: The file descriptor of the connection
+//    events: The events to watch (EPOLLIN, EPOLLOUT, ...)
+//     onEvt: The callback called when events occur
+//     onErr: The callback called when onEvt raises an exception it
+//            doesn't catch (can be NULL)
+//      data: The user data of the connection
+// Output:
+//   Return the connection, or NULL if it couldn't be added
+struct TryCatchReactorConn* TryCatchReactorAdd(
+     struct TryCatchReactor* const that,
+                         int const fd,
+                    uint32_t const events,
+          TryCatchReactorFun const onEvt,
+     TryCatchReactorErrorFun const onErr,
+                       void* const data) {
+
+  struct TryCatchReactorConn* conn =
+    malloc(sizeof(struct TryCatchReactorConn));
+  if (conn == NULL) return NULL;
+  *conn = (struct TryCatchReactorConn){
+    .fd = fd,
+    .onEvt = onEvt,
+    .onErr = onErr,
+    .data = data,
+    .nbExc = 0,
+    .isRemoved = false,
+    .next = that->conns
+  };
+  struct epoll_event evt = {.events = events, .data.ptr = conn};
+  if (
+    epoll_ctl(
+      that->epollFd,
+      EPOLL_CTL_ADD,
+      fd,
+      &evt) != 0) {
+
+    free(conn);
+    return NULL;
+
+  }
+
+  that->conns = conn;
+  return conn;
+
+}
+
+// Function to remove a connection from a reactor, can be called from the
+// callbacks. The file descriptor of the connection is not closed.
+// Inputs:
+//   that: The reactor
+//   conn: The connection, invalid on return
+void TryCatchReactorRemove(
+     struct TryCatchReactor* const that,
+  struct TryCatchReactorConn* const conn) {
+
+  // Remove the connection from the epoll instance, and free it unless
+  // events in the current dispatch may still refer to it
+  epoll_ctl(
+    that->epollFd,
+    EPOLL_CTL_DEL,
+    conn->fd,
+    NULL);
+  conn->isRemoved = true;
+  if (that->isDispatching == false) TryCatchReactorPurge(that);
+
+}
+
+// Function to call the error callback of a connection, in its own
+// TryCatch block, an exception it raises is ignored
+// Inputs:
+//   conn: The connection
+//    exc: The exception
+//   site: The site of the raise (NULL if unknown)
+static void TryCatchReactorError(
+  struct TryCatchReactorConn* const conn,
+                          int const exc,
+   struct TryCatchSite const* const site) {
+
+  int lvl = TryCatchGetLevel();
+  Try {
+
+    conn->onErr(
+      conn,
+      exc,
+      site);
+    TryCatchRestoreLevel(lvl + 1);
+
+  } CatchDefault {
+
+  } EndCatch;
+
+}
+
+// Function to dispatch events to the callback of a connection in its own
+// TryCatch block
+// Inputs:
+//     conn: The connection
+//   events: The events
+static void TryCatchReactorDispatch(
+  struct TryCatchReactorConn* const conn,
+                   uint32_t const events) {
+
+  // The exception is memorised in volatiles as they are modified after
+  // the setjmp
+  volatile int exc = 0;
+  struct TryCatchSite const* volatile site = NULL;
+  int lvl = TryCatchGetLevel();
+  Try {
+
+    conn->onEvt(
+      conn,
+      events);
+
+    // End the blocks the callback may have left open, for EndCatch to
+    // end the block of the dispatch
+    TryCatchRestoreLevel(lvl + 1);
+
+  } CatchDefault {
+
+    exc = TryCatchGetLastExc();
+    site = TryCatchGetLastSite();
+
+  } EndCatch;
+
+  // Pass the exception to the error callback
+  if (exc != 0) {
+
+    ++(conn->nbExc);
+    if (conn->onErr != NULL)
+      TryCatchReactorError(
+        conn,
+        exc,
+        site);
+
+  }
+
+}
+
+// Function to wait for events and dispatch them to the callbacks of the
+// connections
+// Inputs:
+//      that: The reactor
+//   timeout: The maximum time to wait for events in milliseconds, -1 to
+//            wait indefinitely
+// Output:
+//   Return the number of dispatched events, or -1 if the wait has failed
+int TryCatchReactorRun(
+  struct TryCatchReactor* const that,
+                    int const timeout) {
+
+  // Wait for the events, an interruption by a signal is not a failure
+  struct epoll_event evts[TryCatchReactorMaxNbEvent];
+  int nbEvt =
+    epoll_wait(
+      that->epollFd,
+      evts,
+      TryCatchReactorMaxNbEvent,
+      timeout);
+  if (nbEvt < 0) return (errno == EINTR ? 0 : -1);
+
+  // Dispatch the events, skipping the connections removed by a previous
+  // callback
+  that->isDispatching = true;
+  int nbDispatch = 0;
+  for (
+    int iEvt = 0;
+    iEvt < nbEvt;
+    ++iEvt) {
+
+    struct TryCatchReactorConn* conn = evts[iEvt].data.ptr;
+    if (conn->isRemoved) continue;
+    TryCatchReactorDispatch(
+      conn,
+      evts[iEvt].events);
+    ++nbDispatch;
+
+  }
+
+  that->isDispatching = false;
+  TryCatchReactorPurge(that);
+  return nbDispatch;
+
+}
+
+// Function to get the file descriptor of a connection
+// Input:
+//   conn: The connection
+// Output:
+//   Return the file descriptor
+int TryCatchReactorGetFd(
+  struct TryCatchReactorConn const* const conn) {
+
+  return conn->fd;
+
+}
+
+// Function to get the user data of a connection
+// Input:
+//   conn: The connection
+// Output:
+//   Return the user data
+void* TryCatchReactorGetData(
+  struct TryCatchReactorConn const* const conn) {
+
+  return conn->data;
+
+}
+
+// Function to get the number of exceptions raised and not caught by the
+// callbacks of a connection
+// Input:
+//   conn: The connection
+// Output:
+//   Return the number of exceptions
+uint64_t TryCatchReactorGetNbExc(
+  struct TryCatchReactorConn const* const conn) {
+
+  return conn->nbExc;
+
+}
+
+// ------------------ trycatchcreactor.c ------------------
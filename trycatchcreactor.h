@@ -0,0 +1,128 @@
+// ------------------ trycatchcreactor.h ------------------
+
+// Guard against multiple inclusions
+#ifndef TryCATCHCREACTOR_H
+#define TryCATCHCREACTOR_H
+
+// Include external modules header
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Reactor dispatching the events of file descriptors (sockets, pipes,
+// ...) to their callbacks, built on epoll. Each callback runs in its own
+// TryCatch block: an exception it doesn't catch is passed to the error
+// callback of its connection instead of ending the event loop, and the
+// TryCatch blocks it has left open by returning from inside them are
+// ended after the dispatch. A reactor is run by one thread, use one
+// reactor per event loop thread. The reactor relies on epoll and is not
+// available in ANSI C.
+struct TryCatchReactor;
+
+// Connection registered in a reactor
+struct TryCatchReactorConn;
+
+// Function called when events occur on a connection
+// Inputs:
+//     conn: The connection
+//   events: The events (EPOLLIN, EPOLLOUT, EPOLLHUP, ...)
+typedef void (*TryCatchReactorFun)(
+  struct TryCatchReactorConn* conn,
+                     uint32_t events);
+
+// Function called when the callback of a connection raises an exception
+// it doesn't catch
+// Inputs:
+//   conn: The connection
+//    exc: The exception
+//   site: The site of the raise (NULL if unknown)
+typedef void (*TryCatchReactorErrorFun)(
+  struct TryCatchReactorConn* conn,
+                          int exc,
+   struct TryCatchSite const* site);
+
+// Function to create a reactor
+// Output:
+//   Return the reactor, or NULL if it couldn't be created
+struct TryCatchReactor* TryCatchReactorCreate(
+  void);
+
+// Function to free a reactor and its connections. The file descriptors
+// of the connections are not closed.
+// Input:
+//   that: The reactor, set to NULL on return
+void TryCatchReactorFree(
+  struct TryCatchReactor** const that);
+
+// Function to add a connection to a reactor
+// Inputs:
+//      that: The reactor
+//        fd: The file descriptor of the connection
+//    events: The events to watch (EPOLLIN, EPOLLOUT, ...)
+//     onEvt: The callback called when events occur
+//     onErr: The callback called when onEvt raises an exception it
+//            doesn't catch (can be NULL)
+//      data: The user data of the connection
+// Output:
+//   Return the connection, or NULL if it couldn't be added
+struct TryCatchReactorConn* TryCatchReactorAdd(
+     struct TryCatchReactor* const that,
+                         int const fd,
+                    uint32_t const events,
+          TryCatchReactorFun const onEvt,
+     TryCatchReactorErrorFun const onErr,
+                       void* const data);
+
+// Function to remove a connection from a reactor, can be called from the
+// callbacks. The file descriptor of the connection is not closed.
+// Inputs:
+//   that: The reactor
+//   conn: The connection, invalid on return
+void TryCatchReactorRemove(
+     struct TryCatchReactor* const that,
+  struct TryCatchReactorConn* const conn);
+
+// Function to wait for events and dispatch them to the callbacks of the
+// connections
+// Inputs:
+//      that: The reactor
+//   timeout: The maximum time to wait for events in milliseconds, -1 to
+//            wait indefinitely
+// Output:
+//   Return the number of dispatched events, or -1 if the wait has failed
+int TryCatchReactorRun(
+  struct TryCatchReactor* const that,
+                    int const timeout);
+
+// Function to get the file descriptor of a connection
+// Input:
+//   conn: The connection
+// Output:
+//   Return the file descriptor
+int TryCatchReactorGetFd(
+  struct TryCatchReactorConn const* const conn);
+
+// Function to get the user data of a connection
+// Input:
+//   conn: The connection
+// Output:
+//   Return the user data
+void* TryCatchReactorGetData(
+  struct TryCatchReactorConn const* const conn);
+
+// Function to get the number of exceptions raised and not caught by the
+// callbacks of a connection
+// Input:
+//   conn: The connection
+// Output:
+//   Return the number of exceptions
+uint64_t TryCatchReactorGetNbExc(
+  struct TryCatchReactorConn const* const conn);
+
+// End of the guard against multiple inclusion
+#endif
+
+// ------------------ trycatchcreactor.h ------------------
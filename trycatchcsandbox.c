@@ -0,0 +1,825 @@
+// ------------------ trycatchcsandbox.c ------------------
+
+// The sandbox relies on fork, mmap and sockets which are not defined in
+// ANSI C, request their declaration
+#define _GNU_SOURCE
+
+// Include the header
+#include "trycatchcsandbox.h"
+
+// Include external modules header
+#include <stdatomic.h>
+#include <threads.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// Command sent to a helper process
+struct TryCatchSandboxCmd {
+
+  // Function to run
+  TryCatchSandboxFun fun;
+
+  // Size of the input data
+  size_t size;
+
+};
+
+// Request sent to the zygote process of a sandbox
+struct TryCatchSandboxZygoteCmd {
+
+  // Index of the helper process to fork, or -1 to wait for the end of the
+  // helper process pid
+  int iProcess;
+
+  // PID of the helper process to wait for
+  pid_t pid;
+
+};
+
+// Reply of the zygote process of a sandbox, followed for a fork by the
+// socket of the new helper process
+struct TryCatchSandboxZygoteReply {
+
+  // PID of the forked or ended helper process, 0 if the fork failed
+  pid_t pid;
+
+  // Status of the ended helper process
+  int status;
+
+};
+
+// Helper process of a sandbox
+struct TryCatchSandboxProcess {
+
+  // Shared memory region
+  void* data;
+
+  // PID of the helper process, 0 if there is currently none
+  pid_t pid;
+
+  // Socket to communicate with the helper process
+  int fd;
+
+  // Flag to memorise if the process is currently used by a thread
+  _Atomic bool isBusy;
+
+};
+
+// Sandbox
+struct TryCatchSandbox {
+
+  // Size of the shared memory regions
+  size_t dataSize;
+
+  // Number of helper processes
+  int nbProcess;
+
+  // Helper processes
+  struct TryCatchSandboxProcess* processes;
+
+  // PID of the zygote process, forking the helper processes, and socket
+  // to communicate with it (-1 if there is none)
+  pid_t zygotePid;
+  int zygoteFd;
+
+  // Lock serialising the requests to the zygote process
+  mtx_t zygoteLock;
+
+};
+
+// Main loop of a helper process, run the requested functions until the
+// socket is closed by the calling process
+// Input:
+//   process: The helper process
+static void TryCatchSandboxLoop(
+  struct TryCatchSandboxProcess* const process) {
+
+  // Wait for the next command
+  struct TryCatchSandboxCmd cmd;
+  while (
+    recv(
+      process->fd,
+      &cmd,
+      sizeof(cmd),
+      MSG_WAITALL) == sizeof(cmd)) {
+
+    // Run the function and send back the exception if any. The exception
+    // is memorised in a volatile as it is modified after the setjmp.
+    volatile int exc = 0;
+    Try {
+
+      cmd.fun(
+        process->data,
+        cmd.size);
+
+    } CatchDefault {
+
+      exc = TryCatchGetLastExc();
+
+    } EndCatch;
+    int ret = exc;
+    if (
+      send(
+        process->fd,
+        &ret,
+        sizeof(ret),
+        MSG_NOSIGNAL) != sizeof(ret)) {
+
+      break;
+
+    }
+
+  }
+
+}
+
+// Function to send a message on a socket, with a file descriptor
+// attached to it
+// Inputs:
+//   sock: The socket
+//    msg: The message
+//    len: The length of the message
+//     fd: The file descriptor to attach, -1 if none
+// Output:
+//   Return true if the message could be sent, else false
+static bool TryCatchSandboxSendMsg(
+          int const sock,
+  void const* const msg,
+       size_t const len,
+          int const fd) {
+
+  struct iovec iov = {.iov_base = (void*)msg, .iov_len = len};
+  union {
+
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int))];
+
+  } ctrl;
+  memset(
+    &ctrl,
+    0,
+    sizeof(ctrl));
+  struct msghdr hdr = {.msg_iov = &iov, .msg_iovlen = 1};
+  if (fd >= 0) {
+
+    hdr.msg_control = ctrl.buf;
+    hdr.msg_controllen = sizeof(ctrl.buf);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(
+      CMSG_DATA(cmsg),
+      &fd,
+      sizeof(int));
+
+  }
+
+  ssize_t ret = -1;
+  do {
+
+    ret =
+      sendmsg(
+        sock,
+        &hdr,
+        MSG_NOSIGNAL);
+
+  } while (ret < 0 && errno == EINTR);
+  return ret == (ssize_t)len;
+
+}
+
+// Function to receive a message on a socket, with the file descriptor
+// attached to it if any
+// Inputs:
+//   sock: The socket
+//    msg: Where to store the message
+//    len: The length of the message
+//     fd: Where to store the attached file descriptor, -1 if none
+// Output:
+//   Return true if the message could be received, else false
+static bool TryCatchSandboxRecvMsg(
+    int const sock,
+  void* const msg,
+ size_t const len,
+   int* const fd) {
+
+  struct iovec iov = {.iov_base = msg, .iov_len = len};
+  union {
+
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int))];
+
+  } ctrl;
+  struct msghdr hdr = {
+    .msg_iov = &iov,
+    .msg_iovlen = 1,
+    .msg_control = ctrl.buf,
+    .msg_controllen = sizeof(ctrl.buf)};
+  ssize_t ret = -1;
+  do {
+
+    ret =
+      recvmsg(
+        sock,
+        &hdr,
+        MSG_WAITALL | MSG_CMSG_CLOEXEC);
+
+  } while (ret < 0 && errno == EINTR);
+  *fd = -1;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+  if (
+    cmsg != NULL &&
+    cmsg->cmsg_level == SOL_SOCKET &&
+    cmsg->cmsg_type == SCM_RIGHTS) {
+
+    memcpy(
+      fd,
+      CMSG_DATA(cmsg),
+      sizeof(int));
+
+  }
+
+  return ret == (ssize_t)len;
+
+}
+
+// Main loop of the zygote process of a sandbox, forking the helper
+// processes and waiting for their end on request of the calling process,
+// until the socket is closed by the calling process. The zygote process
+// has a single thread, hence the helper processes can be forked safely
+// whatever the threads of the calling process are doing (holding the
+// locks of malloc or stdio for example).
+// Inputs:
+//   that: The sandbox
+//     fd: The socket to communicate with the calling process
+static void TryCatchSandboxZygoteLoop(
+  struct TryCatchSandbox* const that,
+                    int const fd) {
+
+  // Wait for the next request
+  struct TryCatchSandboxZygoteCmd cmd;
+  while (
+    recv(
+      fd,
+      &cmd,
+      sizeof(cmd),
+      MSG_WAITALL) == sizeof(cmd)) {
+
+    struct TryCatchSandboxZygoteReply reply = {.pid = 0, .status = 0};
+    int helperFd = -1;
+
+    // Fork a helper process, its socket is sent to the calling process
+    // and closed here, the helper process is then the only one holding
+    // the other end
+    if (cmd.iProcess >= 0 && cmd.iProcess < that->nbProcess) {
+
+      int fds[2];
+      if (
+        socketpair(
+          AF_UNIX,
+          SOCK_STREAM | SOCK_CLOEXEC,
+          0,
+          fds) == 0) {
+
+        pid_t pid = fork();
+        if (pid == 0) {
+
+          close(fd);
+          close(fds[0]);
+          struct TryCatchSandboxProcess* process =
+            that->processes + cmd.iProcess;
+          process->fd = fds[1];
+          TryCatchSandboxLoop(process);
+          _exit(EXIT_SUCCESS);
+
+        }
+
+        close(fds[1]);
+        if (pid > 0) {
+
+          reply.pid = pid;
+          helperFd = fds[0];
+
+        } else close(fds[0]);
+
+      }
+
+    // Else, wait for the end of a helper process
+    } else {
+
+      while (
+        waitpid(
+          cmd.pid,
+          &(reply.status),
+          0) < 0 &&
+        errno == EINTR);
+      reply.pid = cmd.pid;
+
+    }
+
+    bool isSent =
+      TryCatchSandboxSendMsg(
+        fd,
+        &reply,
+        sizeof(reply),
+        helperFd);
+    if (helperFd >= 0) close(helperFd);
+    if (isSent == false) break;
+
+  }
+
+}
+
+// Function to fork the zygote process of a sandbox, once its shared
+// memory regions have been created
+// Input:
+//   that: The sandbox
+// Output:
+//   Return true if the zygote process could be forked, else false
+static bool TryCatchSandboxForkZygote(
+  struct TryCatchSandbox* const that) {
+
+  // Create the socket
+  int fds[2];
+  if (
+    socketpair(
+      AF_UNIX,
+      SOCK_STREAM | SOCK_CLOEXEC,
+      0,
+      fds) != 0) {
+
+    return false;
+
+  }
+
+  // Fork the zygote process
+  pid_t pid = fork();
+  if (pid < 0) {
+
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+
+  }
+
+  // In the zygote process
+  if (pid == 0) {
+
+    // Restore the default action of the fatal signals, whose handlers
+    // (set by TryCatchInitHandlerSigSegv or the flight recorder) would be
+    // inherited by the helper processes: a helper process must end on a
+    // fault to be replaced, instead of catching it and staying in the
+    // pool with a corrupted memory
+    int const fatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+    for (
+      size_t iSignal = 0;
+      iSignal < sizeof(fatalSignals) / sizeof(fatalSignals[0]);
+      ++iSignal) {
+
+      signal(
+        fatalSignals[iSignal],
+        SIG_DFL);
+
+    }
+
+    close(fds[0]);
+    TryCatchSandboxZygoteLoop(
+      that,
+      fds[1]);
+    _exit(EXIT_SUCCESS);
+
+  }
+
+  // In the calling process
+  close(fds[1]);
+  that->zygoteFd = fds[0];
+  that->zygotePid = pid;
+  return true;
+
+}
+
+// Function to send a request to the zygote process of a sandbox and get
+// its reply
+// Inputs:
+//     that: The sandbox
+//      cmd: The request
+//    reply: Where to store the reply
+//   sockFd: Where to store the socket of the forked helper process, -1 if
+//           none
+// Output:
+//   Return true if the reply could be received, else false
+static bool TryCatchSandboxZygoteRequest(
+            struct TryCatchSandbox* const that,
+  struct TryCatchSandboxZygoteCmd const cmd,
+  struct TryCatchSandboxZygoteReply* const reply,
+                               int* const sockFd) {
+
+  mtx_lock(&(that->zygoteLock));
+  bool isOk =
+    TryCatchSandboxSendMsg(
+      that->zygoteFd,
+      &cmd,
+      sizeof(cmd),
+      -1) &&
+    TryCatchSandboxRecvMsg(
+      that->zygoteFd,
+      reply,
+      sizeof(*reply),
+      sockFd);
+  mtx_unlock(&(that->zygoteLock));
+  return isOk;
+
+}
+
+// Function to fork a helper process, through the zygote process of the
+// sandbox
+// Inputs:
+//      that: The sandbox
+//   process: The helper process
+// Output:
+//   Return true if the helper process could be forked, else false
+static bool TryCatchSandboxSpawn(
+         struct TryCatchSandbox* const that,
+  struct TryCatchSandboxProcess* const process) {
+
+  struct TryCatchSandboxZygoteCmd cmd = {
+    .iProcess = (int)(process - that->processes),
+    .pid = 0};
+  struct TryCatchSandboxZygoteReply reply;
+  int fd = -1;
+  bool isOk =
+    TryCatchSandboxZygoteRequest(
+      that,
+      cmd,
+      &reply,
+      &fd);
+  if (isOk == false || reply.pid <= 0 || fd < 0) {
+
+    if (fd >= 0) close(fd);
+    return false;
+
+  }
+
+  process->fd = fd;
+  process->pid = reply.pid;
+  return true;
+
+}
+
+// Function to end a helper process
+// Inputs:
+//      that: The sandbox
+//   process: The helper process
+// Output:
+//   Return the exception corresponding to the status of the helper
+//   process
+static int TryCatchSandboxReap(
+         struct TryCatchSandbox* const that,
+  struct TryCatchSandboxProcess* const process) {
+
+  // Close the socket, which ends the helper process if it is still alive,
+  // and let the zygote process wait for it
+  close(process->fd);
+  struct TryCatchSandboxZygoteCmd cmd = {
+    .iProcess = -1,
+    .pid = process->pid};
+  struct TryCatchSandboxZygoteReply reply = {.pid = 0, .status = 0};
+  int fd = -1;
+  TryCatchSandboxZygoteRequest(
+    that,
+    cmd,
+    &reply,
+    &fd);
+  process->pid = 0;
+
+  // Convert the status to an exception
+  int status = reply.status;
+  if (
+    WIFSIGNALED(status) &&
+    (WTERMSIG(status) == SIGSEGV || WTERMSIG(status) == SIGBUS)) {
+
+    return TryCatchExc_Segv;
+
+  }
+
+  return TryCatchExc_SandboxCrashed;
+
+}
+
+// Function to create a sandbox. A zygote process is forked from the
+// calling thread, only this thread exists in it, and the helper processes
+// are forked from the zygote process, at the creation of the sandbox and
+// to replace the crashed ones. Functions run in the sandbox must have
+// been loaded in the process before its creation.
+// Inputs:
+//   nbProcess: The number of helper processes, which is the max number of
+//              functions which can run in the sandbox at the same time
+//    dataSize: The size in bytes of the shared memory region of each
+//              helper process
+// Output:
+//   Return the sandbox, or NULL if it couldn't be created
+struct TryCatchSandbox* TryCatchSandboxCreate(
+     int const nbProcess,
+  size_t const dataSize) {
+
+  // Allocate memory for the sandbox
+  if (nbProcess <= 0) return NULL;
+  struct TryCatchSandbox* that = malloc(sizeof(struct TryCatchSandbox));
+  if (that == NULL) return NULL;
+  that->dataSize = dataSize;
+  that->nbProcess = nbProcess;
+  that->zygotePid = 0;
+  that->zygoteFd = -1;
+  if (
+    mtx_init(
+      &(that->zygoteLock),
+      mtx_plain) != thrd_success) {
+
+    free(that);
+    return NULL;
+
+  }
+
+  that->processes =
+    calloc(
+      (size_t)nbProcess,
+      sizeof(struct TryCatchSandboxProcess));
+  if (that->processes == NULL) {
+
+    mtx_destroy(&(that->zygoteLock));
+    free(that);
+    return NULL;
+
+  }
+
+  // Create the shared memory regions. The regions stay mapped in the
+  // calling process for the life of the sandbox and are inherited by the
+  // zygote process, hence by all the helper processes.
+  bool isOk = true;
+  for (
+    int iProcess = 0;
+    iProcess < nbProcess && isOk;
+    ++iProcess) {
+
+    struct TryCatchSandboxProcess* process = that->processes + iProcess;
+    process->data =
+      mmap(
+        NULL,
+        dataSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (process->data == MAP_FAILED) {
+
+      process->data = NULL;
+      isOk = false;
+
+    }
+
+  }
+
+  // Fork the zygote process, then the helper processes from it
+  if (isOk) isOk = TryCatchSandboxForkZygote(that);
+  for (
+    int iProcess = 0;
+    iProcess < nbProcess && isOk;
+    ++iProcess) {
+
+    isOk =
+      TryCatchSandboxSpawn(
+        that,
+        that->processes + iProcess);
+
+  }
+
+  if (isOk == false) TryCatchSandboxFree(&that);
+  return that;
+
+}
+
+// Function to free a sandbox and end its helper processes
+// Input:
+//   that: The sandbox, set to NULL on return
+void TryCatchSandboxFree(
+  struct TryCatchSandbox** const that) {
+
+  if (that == NULL || *that == NULL) return;
+
+  // Loop on the helper processes
+  for (
+    int iProcess = 0;
+    iProcess < (*that)->nbProcess;
+    ++iProcess) {
+
+    struct TryCatchSandboxProcess* process = (*that)->processes + iProcess;
+    if (process->pid != 0)
+      TryCatchSandboxReap(
+        *that,
+        process);
+    if (process->data != NULL)
+      munmap(
+        process->data,
+        (*that)->dataSize);
+
+  }
+
+  // End the zygote process by closing its socket, and wait for it
+  if ((*that)->zygotePid != 0) {
+
+    close((*that)->zygoteFd);
+    while (
+      waitpid(
+        (*that)->zygotePid,
+        NULL,
+        0) < 0 &&
+      errno == EINTR);
+
+  }
+
+  mtx_destroy(&((*that)->zygoteLock));
+  free((*that)->processes);
+  free(*that);
+  *that = NULL;
+
+}
+
+// Function to end a helper process still running a function whose result
+// is not waited for anymore
+// Inputs:
+//      that: The sandbox
+//   process: The helper process
+static void TryCatchSandboxAbandon(
+         struct TryCatchSandbox* const that,
+  struct TryCatchSandboxProcess* const process) {
+
+  kill(
+    process->pid,
+    SIGKILL);
+  TryCatchSandboxReap(
+    that,
+    process);
+
+}
+
+// Function to run a function in a helper process of the sandbox, waiting
+// for a helper process to be available if all are busy. If the function
+// raises an exception uncaught in the helper process, the same exception
+// is raised in the calling process. If the helper process crashes, the
+// exception TryCatchExc_Segv is raised for SIGSEGV and SIGBUS, else
+// TryCatchExc_SandboxCrashed is raised, and the helper process is replaced
+// by a new one. TryCatchExc_OutOfRange is raised if the input or output
+// data don't fit in the shared memory region. The signals interrupting
+// the wait for the helper process are ignored, except the one of a
+// cancellation (cf. TryCatchInitCancelSignal): the helper process is then
+// ended and replaced, and TryCatchExc_Cancelled is raised.
+// Inputs:
+//      that: The sandbox
+//       fun: The function to run
+//        in: The input data copied in the shared memory region before
+//            running the function (can be NULL)
+//    inSize: The size of the input data
+//       out: Where to copy the shared memory region after running the
+//            function (can be NULL)
+//   outSize: The size of the output data
+//      site: Descriptor of the site of the call, where the exceptions are
+//            raised
+void TryCatchSandboxRun_(
+  struct TryCatchSandbox* const that,
+       TryCatchSandboxFun const fun,
+              void const* const in,
+                   size_t const inSize,
+                    void* const out,
+                   size_t const outSize,
+     struct TryCatchSite* const site) {
+
+  if (inSize > that->dataSize || outSize > that->dataSize)
+    Raise_(
+      TryCatchExc_OutOfRange,
+      site);
+
+  // Get an available helper process
+  struct TryCatchSandboxProcess* process = NULL;
+  for (
+    int iProcess = 0;
+    process == NULL;
+    iProcess = (iProcess + 1) % that->nbProcess) {
+
+    bool isBusy = false;
+    if (
+      atomic_compare_exchange_strong(
+        &(that->processes[iProcess].isBusy),
+        &isBusy,
+        true)) {
+
+      process = that->processes + iProcess;
+
+    } else if (iProcess == that->nbProcess - 1) sched_yield();
+
+  }
+
+  // Replace the helper process if it has previously crashed, the zygote
+  // process forks the new one
+  int exc = 0;
+  if (
+    process->pid == 0 &&
+    TryCatchSandboxSpawn(
+      that,
+      process) == false) {
+
+    exc = TryCatchExc_SandboxCrashed;
+
+  }
+
+  // Send the input data and the command to the helper process, and wait
+  // for its reply. The calls interrupted by a signal are restarted unless
+  // the context has been cancelled meanwhile.
+  bool isCancelled = false;
+  if (exc == 0) {
+
+    if (in != NULL)
+      memcpy(
+        process->data,
+        in,
+        inSize);
+    struct TryCatchSandboxCmd cmd = {.fun = fun, .size = inSize};
+    int ret = 0;
+    ssize_t len = -1;
+    do {
+
+      len =
+        send(
+          process->fd,
+          &cmd,
+          sizeof(cmd),
+          MSG_NOSIGNAL);
+
+    } while (
+      len < 0 &&
+      errno == EINTR &&
+      (isCancelled = TryCatchIsCancelPending()) == false);
+    if (len == (ssize_t)sizeof(cmd)) {
+
+      do {
+
+        len =
+          recv(
+            process->fd,
+            &ret,
+            sizeof(ret),
+            MSG_WAITALL);
+
+      } while (
+        len < 0 &&
+        errno == EINTR &&
+        (isCancelled = TryCatchIsCancelPending()) == false);
+
+    }
+
+    // Get the output data
+    if (len == (ssize_t)sizeof(ret)) {
+
+      exc = ret;
+      if (exc == 0 && out != NULL)
+        memcpy(
+          out,
+          process->data,
+          outSize);
+
+    // Else, if the context has been cancelled, end the helper process
+    // which may still be running the function, and take over the request
+    // of cancellation
+    } else if (isCancelled) {
+
+      TryCatchSandboxAbandon(
+        that,
+        process);
+      TryCatchCtxClearCancel(TryCatchGetCtx());
+      exc = TryCatchExc_Cancelled;
+
+    // Else, the helper process has crashed
+    } else
+      exc =
+        TryCatchSandboxReap(
+          that,
+          process);
+
+  }
+
+  // Release the helper process and raise the exception if any
+  atomic_store(
+    &(process->isBusy),
+    false);
+  if (exc != 0)
+    Raise_(
+      exc,
+      site);
+
+}
+
+// ------------------ trycatchcsandbox.c ------------------
@@ -0,0 +1,96 @@
+// ------------------ trycatchcsandbox.h ------------------
+
+// Guard against multiple inclusions
+#ifndef TryCATCHCSANDBOX_H
+#define TryCATCHCSANDBOX_H
+
+// Include external modules header
+#include <stdlib.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Sandbox running functions in a pool of pre-forked helper processes, to
+// isolate the calling process from functions susceptible to corrupt the
+// memory or crash. Data are passed to and from the helper processes
+// through a shared memory region. The sandbox relies on fork and is not
+// available in ANSI C.
+struct TryCatchSandbox;
+
+// Function run in a helper process
+// Inputs:
+//   data: The shared memory region, containing the input data when the
+//         function is called, and where the function writes its output
+//         data
+//   size: The size of the shared memory region
+typedef void (*TryCatchSandboxFun)(
+   void* data,
+  size_t size);
+
+// Function to create a sandbox. A zygote process is forked from the
+// calling thread, only this thread exists in it, and the helper processes
+// are forked from the zygote process, at the creation of the sandbox and
+// to replace the crashed ones. Functions run in the sandbox must have
+// been loaded in the process before its creation.
+// Inputs:
+//   nbProcess: The number of helper processes, which is the max number of
+//              functions which can run in the sandbox at the same time
+//    dataSize: The size in bytes of the shared memory region of each
+//              helper process
+// Output:
+//   Return the sandbox, or NULL if it couldn't be created
+struct TryCatchSandbox* TryCatchSandboxCreate(
+     int const nbProcess,
+  size_t const dataSize);
+
+// Function to free a sandbox and end its helper processes
+// Input:
+//   that: The sandbox, set to NULL on return
+void TryCatchSandboxFree(
+  struct TryCatchSandbox** const that);
+
+// Function to run a function in a helper process of the sandbox, waiting
+// for a helper process to be available if all are busy. If the function
+// raises an exception uncaught in the helper process, the same exception
+// is raised in the calling process. If the helper process crashes, the
+// exception TryCatchExc_Segv is raised for SIGSEGV and SIGBUS, else
+// TryCatchExc_SandboxCrashed is raised, and the helper process is replaced
+// by a new one. TryCatchExc_OutOfRange is raised if the input or output
+// data don't fit in the shared memory region. The signals interrupting
+// the wait for the helper process are ignored, except the one of a
+// cancellation (cf. TryCatchInitCancelSignal): the helper process is then
+// ended and replaced, and TryCatchExc_Cancelled is raised.
+// Inputs:
+//      that: The sandbox
+//       fun: The function to run
+//        in: The input data copied in the shared memory region before
+//            running the function (can be NULL)
+//    inSize: The size of the input data
+//       out: Where to copy the shared memory region after running the
+//            function (can be NULL)
+//   outSize: The size of the output data
+//      site: Descriptor of the site of the call, where the exceptions are
+//            raised
+void TryCatchSandboxRun_(
+  struct TryCatchSandbox* const that,
+       TryCatchSandboxFun const fun,
+              void const* const in,
+                   size_t const inSize,
+                    void* const out,
+                   size_t const outSize,
+     struct TryCatchSite* const site);
+
+// Wrapper to call TryCatchSandboxRun_ with the descriptor of the site of
+// the call
+#define TryCatchSandboxRun(that, fun, in, inSize, out, outSize)   \
+  do {                                                            \
+    static struct TryCatchSite tryCatchSandboxSite = {            \
+      __FILE__, __LINE__, __func__, 0};                           \
+    TryCatchSandboxRun_(                                          \
+      that, fun, in, inSize, out, outSize, &tryCatchSandboxSite); \
+  } while (false)
+
+// End of the guard against multiple inclusion
+#endif
+
+// ------------------ trycatchcsandbox.h ------------------
@@ -0,0 +1,640 @@
+// ------------------ trycatchcsupervisor.c ------------------
+
+// Include the header
+#include "trycatchcsupervisor.h"
+
+// Include external modules header
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+
+// Orders given by the supervisor to a worker
+enum TryCatchSupervisorOrder {
+
+  TryCatchSupervisorOrder_None,
+  TryCatchSupervisorOrder_Run,
+  TryCatchSupervisorOrder_Exit
+
+};
+
+// Worker of a supervisor
+struct TryCatchSupervisorWorker {
+
+  // Supervisor of the worker
+  struct TryCatchSupervisor* supervisor;
+
+  // Function and argument of the worker
+  TryCatchSupervisorFun fun;
+  void* arg;
+
+  // Thread of the worker
+  thrd_t thread;
+
+  // Flag to memorise if the thread of the worker has been started
+  bool isStarted;
+
+  // Context of the thread of the worker, NULL until the thread has
+  // started
+  _Atomic(struct TryCatchCtx*) ctx;
+
+  // Next order of the supervisor (TryCatchSupervisorOrder), protected by
+  // the lock of the supervisor
+  int order;
+
+  // Condition signalled when an order is given to the worker, on which
+  // the idle worker waits
+  cnd_t cond;
+
+  // Exception which has ended the function (0 if it has returned), and
+  // its site, written by the worker before it notifies the supervisor
+  int exc;
+  struct TryCatchSite const* site;
+
+  // Next worker in the queue of notifications of the supervisor
+  struct TryCatchSupervisorWorker* next;
+
+  // Flags to memorise if the function of the worker is running and if it
+  // must be restarted once all the workers have stopped, used by the
+  // supervising thread only
+  bool isRunning;
+  bool isRestartPending;
+
+  // Number of restarts
+  _Atomic uint64_t nbRestart;
+
+};
+
+// Supervisor
+struct TryCatchSupervisor {
+
+  // Number of workers
+  int nbWorker;
+
+  // Workers
+  struct TryCatchSupervisorWorker* workers;
+
+  // Strategy of restart
+  enum TryCatchSupervisorStrategy strategy;
+
+  // Restart intensity: max number of restarts within the period (in
+  // nanoseconds), and ring of the times of the last restarts
+  int maxRestart;
+  uint64_t period;
+  uint64_t* restartTimes;
+  int nbRestart;
+
+  // Queue of notifications, a lock-free stack of the workers whose
+  // function has ended, pushed by the workers and emptied at once by the
+  // supervising thread
+  _Atomic(struct TryCatchSupervisorWorker*) notifs;
+
+  // Flag to memorise if the stop has been requested
+  _Atomic bool isStopRequested;
+
+  // Lock protecting the orders of the workers and the waits on the
+  // conditions
+  mtx_t lock;
+
+  // Condition signalled when a worker publishes its context or pushes a
+  // notification and when the stop is requested, on which the idle
+  // supervising thread waits
+  cnd_t cond;
+
+};
+
+// Function to get the current time
+// Output:
+//   Return the time in nanoseconds
+static uint64_t TryCatchSupervisorNow(
+  void) {
+
+  struct timespec ts;
+  timespec_get(
+    &ts,
+    TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+}
+
+// Function to wake up the supervising thread
+// Input:
+//   that: The supervisor
+static void TryCatchSupervisorWakeUp(
+  struct TryCatchSupervisor* const that) {
+
+  // The condition is signalled under the lock, so the supervising thread
+  // can't miss it between the check of its predicate and its wait
+  mtx_lock(&(that->lock));
+  cnd_signal(&(that->cond));
+  mtx_unlock(&(that->lock));
+
+}
+
+// Function to give an order to a worker and wake it up
+// Input:
+//   worker: The worker
+//    order: The order
+static void TryCatchSupervisorOrder(
+  struct TryCatchSupervisorWorker* const worker,
+                              int const order) {
+
+  mtx_lock(&(worker->supervisor->lock));
+  worker->order = order;
+  cnd_signal(&(worker->cond));
+  mtx_unlock(&(worker->supervisor->lock));
+
+}
+
+// Function to run the function of a worker in its root TryCatch block
+// Input:
+//   worker: The worker, its exception and site are updated
+static void TryCatchSupervisorRunWorker(
+  struct TryCatchSupervisorWorker* const worker) {
+
+  // The exception is memorised in volatiles as they are modified after
+  // the setjmp
+  volatile int exc = 0;
+  struct TryCatchSite const* volatile site = NULL;
+  int lvl = TryCatchGetLevel();
+  Try {
+
+    worker->fun(worker->arg);
+
+    // End the blocks the function may have left open, for EndCatch to
+    // end the root block
+    TryCatchRestoreLevel(lvl + 1);
+
+  } CatchDefault {
+
+    exc = TryCatchGetLastExc();
+    site = TryCatchGetLastSite();
+
+  } EndCatch;
+  worker->exc = exc;
+  worker->site = site;
+
+}
+
+// Main function of the thread of a worker, run the function of the worker
+// each time the supervisor orders it, until it orders to exit
+// Input:
+//   arg: The worker
+// Output:
+//   Return 0
+static int TryCatchSupervisorWorkerMain(
+  void* arg) {
+
+  struct TryCatchSupervisorWorker* worker = arg;
+  struct TryCatchSupervisor* supervisor = worker->supervisor;
+  atomic_store(
+    &(worker->ctx),
+    TryCatchGetCtx());
+  TryCatchSupervisorWakeUp(supervisor);
+  for (;;) {
+
+    // Wait for the next order
+    mtx_lock(&(supervisor->lock));
+    while (worker->order == TryCatchSupervisorOrder_None)
+      cnd_wait(
+        &(worker->cond),
+        &(supervisor->lock));
+    int order = worker->order;
+    worker->order = TryCatchSupervisorOrder_None;
+    mtx_unlock(&(supervisor->lock));
+    if (order == TryCatchSupervisorOrder_Exit) break;
+
+    // Run the function and notify the supervisor when it ends
+    TryCatchSupervisorRunWorker(worker);
+    struct TryCatchSupervisorWorker* head = atomic_load(&(supervisor->notifs));
+    do {
+
+      worker->next = head;
+
+    } while (
+      atomic_compare_exchange_weak(
+        &(supervisor->notifs),
+        &head,
+        worker) == false);
+    TryCatchSupervisorWakeUp(supervisor);
+
+  }
+
+  return 0;
+
+}
+
+// Function to order a worker to run its function
+// Input:
+//   worker: The worker
+static void TryCatchSupervisorStart(
+  struct TryCatchSupervisorWorker* const worker) {
+
+  // A cancellation requested while the function was ending targets the
+  // previous run, clear it
+  TryCatchCtxClearCancel(atomic_load(&(worker->ctx)));
+  worker->isRunning = true;
+  TryCatchSupervisorOrder(
+    worker,
+    TryCatchSupervisorOrder_Run);
+
+}
+
+// Function to cancel the running workers of a supervisor
+// Input:
+//   that: The supervisor
+static void TryCatchSupervisorCancelAll(
+  struct TryCatchSupervisor* const that) {
+
+  for (
+    int iWorker = 0;
+    iWorker < that->nbWorker;
+    ++iWorker) {
+
+    if (that->workers[iWorker].isRunning)
+      TryCatchCancel(atomic_load(&(that->workers[iWorker].ctx)));
+
+  }
+
+}
+
+// Function to check the restart intensity of a supervisor and record a
+// restart
+// Input:
+//   that: The supervisor
+// Output:
+//   Return true if the restart is allowed, false if there has already
+//   been maxRestart restarts within the period
+static bool TryCatchSupervisorRecordRestart(
+  struct TryCatchSupervisor* const that) {
+
+  if (that->maxRestart <= 0) return false;
+
+  // The ring holds the times of the last maxRestart restarts, the oldest
+  // one is the next to be overwritten
+  uint64_t now = TryCatchSupervisorNow();
+  uint64_t* oldest = that->restartTimes + that->nbRestart % that->maxRestart;
+  if (that->nbRestart >= that->maxRestart && now - *oldest < that->period)
+    return false;
+  *oldest = now;
+  ++(that->nbRestart);
+  return true;
+
+}
+
+// Function to create a supervisor and start the threads of its workers,
+// their functions are run by TryCatchSupervisorRun
+// Inputs:
+//     nbWorker: The number of workers
+//         funs: The functions of the workers
+//         args: The arguments of the workers (can be NULL if all are NULL)
+//     strategy: The strategy of restart
+//   maxRestart: The max number of restarts within period
+//       period: The period of the restart intensity, in seconds
+// Output:
+//   Return the supervisor, or NULL if it couldn't be created
+struct TryCatchSupervisor* TryCatchSupervisorCreate(
+                             int const nbWorker,
+        TryCatchSupervisorFun const* const funs,
+                     void* const* const args,
+  enum TryCatchSupervisorStrategy const strategy,
+                             int const maxRestart,
+                          double const period) {
+
+  // Allocate memory for the supervisor
+  if (nbWorker <= 0) return NULL;
+  struct TryCatchSupervisor* that = malloc(sizeof(struct TryCatchSupervisor));
+  if (that == NULL) return NULL;
+  that->nbWorker = nbWorker;
+  that->strategy = strategy;
+  that->maxRestart = maxRestart;
+  that->period = (uint64_t)(period * 1e9);
+  that->nbRestart = 0;
+  atomic_init(&(that->notifs), NULL);
+  atomic_init(&(that->isStopRequested), false);
+  that->workers =
+    malloc(sizeof(struct TryCatchSupervisorWorker) * (size_t)nbWorker);
+  that->restartTimes =
+    malloc(sizeof(uint64_t) * (size_t)(maxRestart > 0 ? maxRestart : 1));
+  bool isLockInit = (mtx_init(&(that->lock), mtx_plain) == thrd_success);
+  bool isCondInit = (cnd_init(&(that->cond)) == thrd_success);
+  if (
+    that->workers == NULL || that->restartTimes == NULL ||
+    isLockInit == false || isCondInit == false) {
+
+    if (isLockInit) mtx_destroy(&(that->lock));
+    if (isCondInit) cnd_destroy(&(that->cond));
+    free(that->workers);
+    free(that->restartTimes);
+    free(that);
+    return NULL;
+
+  }
+
+  // Initialise the workers. If the condition of a worker can't be
+  // initialised the supervisor is reduced to the workers before it, to be
+  // freed.
+  bool isOk = true;
+  for (
+    int iWorker = 0;
+    iWorker < nbWorker && isOk;
+    ++iWorker) {
+
+    struct TryCatchSupervisorWorker* worker = that->workers + iWorker;
+    worker->supervisor = that;
+    worker->fun = funs[iWorker];
+    worker->arg = (args != NULL ? args[iWorker] : NULL);
+    worker->isStarted = false;
+    atomic_init(&(worker->ctx), NULL);
+    worker->order = TryCatchSupervisorOrder_None;
+    worker->exc = 0;
+    worker->site = NULL;
+    worker->next = NULL;
+    worker->isRunning = false;
+    worker->isRestartPending = false;
+    atomic_init(&(worker->nbRestart), 0);
+    isOk = (cnd_init(&(worker->cond)) == thrd_success);
+    if (isOk == false) that->nbWorker = iWorker;
+
+  }
+
+  // Start the threads of the workers, and wait for them to publish their
+  // context, which must be available to cancel them
+  for (
+    int iWorker = 0;
+    iWorker < nbWorker && isOk;
+    ++iWorker) {
+
+    struct TryCatchSupervisorWorker* worker = that->workers + iWorker;
+    isOk =
+      thrd_create(
+        &(worker->thread),
+        TryCatchSupervisorWorkerMain,
+        worker) == thrd_success;
+    worker->isStarted = isOk;
+
+  }
+
+  mtx_lock(&(that->lock));
+  for (
+    int iWorker = 0;
+    iWorker < nbWorker && isOk;
+    ++iWorker) {
+
+    while (atomic_load(&(that->workers[iWorker].ctx)) == NULL)
+      cnd_wait(
+        &(that->cond),
+        &(that->lock));
+
+  }
+
+  mtx_unlock(&(that->lock));
+
+  if (isOk == false) TryCatchSupervisorFree(&that);
+  return that;
+
+}
+
+// Function to free a supervisor, once TryCatchSupervisorRun has returned,
+// ending the threads of its workers
+// Input:
+//   that: The supervisor, set to NULL on return
+void TryCatchSupervisorFree(
+  struct TryCatchSupervisor** const that) {
+
+  if (that == NULL || *that == NULL) return;
+  for (
+    int iWorker = 0;
+    iWorker < (*that)->nbWorker;
+    ++iWorker) {
+
+    struct TryCatchSupervisorWorker* worker = (*that)->workers + iWorker;
+    if (worker->isStarted) {
+
+      TryCatchSupervisorOrder(
+        worker,
+        TryCatchSupervisorOrder_Exit);
+      thrd_join(
+        worker->thread,
+        NULL);
+
+    }
+
+    cnd_destroy(&(worker->cond));
+
+  }
+
+  mtx_destroy(&((*that)->lock));
+  cnd_destroy(&((*that)->cond));
+  free((*that)->workers);
+  free((*that)->restartTimes);
+  free(*that);
+  *that = NULL;
+
+}
+
+// Function to handle the end of the function of a worker
+// Inputs:
+//     that: The supervisor
+//   worker: The worker
+//   isStop: Flag to memorise if the workers are being stopped, updated if
+//           the supervisor gives up
+// Output:
+//   Return the number of workers started again
+static int TryCatchSupervisorHandle(
+         struct TryCatchSupervisor* const that,
+  struct TryCatchSupervisorWorker* const worker,
+                            bool* const isStop) {
+
+  // A worker which has returned normally, or failed while the workers are
+  // being stopped or restarted all together, is not restarted now
+  worker->isRunning = false;
+  if (worker->exc == 0 || *isStop || worker->isRestartPending) return 0;
+
+  // Give up if the restart intensity is exceeded
+  if (TryCatchSupervisorRecordRestart(that) == false) {
+
+    *isStop = true;
+    TryCatchSupervisorCancelAll(that);
+    return 0;
+
+  }
+
+  // Restart the worker alone, or cancel the running workers to restart
+  // them all once they have stopped
+  if (that->strategy == TryCatchSupervisorStrategy_OneForOne) {
+
+    atomic_fetch_add(&(worker->nbRestart), 1);
+    TryCatchSupervisorStart(worker);
+    return 1;
+
+  }
+
+  worker->isRestartPending = true;
+  for (
+    int iWorker = 0;
+    iWorker < that->nbWorker;
+    ++iWorker) {
+
+    if (that->workers[iWorker].isRunning)
+      that->workers[iWorker].isRestartPending = true;
+
+  }
+
+  TryCatchSupervisorCancelAll(that);
+  return 0;
+
+}
+
+// Function to run the workers of a supervisor and restart them when they
+// fail, until they have all returned or have been stopped. To be called
+// by one thread only, the supervising thread.
+// Input:
+//   that: The supervisor
+// Output:
+//   Return true if all the workers have returned normally, false if the
+//   supervisor has given up or has been stopped
+bool TryCatchSupervisorRun(
+  struct TryCatchSupervisor* const that) {
+
+  // Start all the workers
+  for (
+    int iWorker = 0;
+    iWorker < that->nbWorker;
+    ++iWorker) {
+
+    TryCatchSupervisorStart(that->workers + iWorker);
+
+  }
+
+  int nbRunning = that->nbWorker;
+  bool isStop = false;
+  while (nbRunning > 0) {
+
+    // Wait for a notification, or for the stop request if the workers
+    // are not being stopped yet
+    mtx_lock(&(that->lock));
+    while (
+      atomic_load(&(that->notifs)) == NULL &&
+      (isStop || atomic_load(&(that->isStopRequested)) == false)) {
+
+      cnd_wait(
+        &(that->cond),
+        &(that->lock));
+
+    }
+
+    mtx_unlock(&(that->lock));
+
+    // Cancel the workers if the stop has been requested
+    if (isStop == false && atomic_load(&(that->isStopRequested))) {
+
+      isStop = true;
+      TryCatchSupervisorCancelAll(that);
+
+    }
+
+    // Get the notifications, in their order of arrival
+    struct TryCatchSupervisorWorker* notifs =
+      atomic_exchange(
+        &(that->notifs),
+        NULL);
+    if (notifs == NULL) continue;
+    struct TryCatchSupervisorWorker* ordered = NULL;
+    while (notifs != NULL) {
+
+      struct TryCatchSupervisorWorker* next = notifs->next;
+      notifs->next = ordered;
+      ordered = notifs;
+      notifs = next;
+
+    }
+
+    // Handle the ended workers. The next one is read before handling the
+    // current one, which may notify again once restarted.
+    while (ordered != NULL) {
+
+      struct TryCatchSupervisorWorker* worker = ordered;
+      ordered = worker->next;
+      --nbRunning;
+      nbRunning +=
+        TryCatchSupervisorHandle(
+          that,
+          worker,
+          &isStop);
+
+    }
+
+    // Restart all together the workers pending restart once they have
+    // all stopped
+    if (nbRunning == 0) {
+
+      for (
+        int iWorker = 0;
+        iWorker < that->nbWorker;
+        ++iWorker) {
+
+        struct TryCatchSupervisorWorker* worker = that->workers + iWorker;
+        if (worker->isRestartPending) {
+
+          worker->isRestartPending = false;
+          if (isStop == false) {
+
+            atomic_fetch_add(&(worker->nbRestart), 1);
+            TryCatchSupervisorStart(worker);
+            ++nbRunning;
+
+          }
+
+        }
+
+      }
+
+    }
+
+  }
+
+  // Check if the workers have all returned normally
+  bool isOk = (isStop == false);
+  for (
+    int iWorker = 0;
+    iWorker < that->nbWorker;
+    ++iWorker) {
+
+    if (that->workers[iWorker].exc != 0) isOk = false;
+
+  }
+
+  return isOk;
+
+}
+
+// Function to stop the workers of a supervisor, can be called from any
+// thread including the workers. The workers are cancelled and
+// TryCatchSupervisorRun returns once they have all stopped.
+// Input:
+//   that: The supervisor
+void TryCatchSupervisorStop(
+  struct TryCatchSupervisor* const that) {
+
+  atomic_store(
+    &(that->isStopRequested),
+    true);
+  TryCatchSupervisorWakeUp(that);
+
+}
+
+// Function to get the number of restarts of a worker
+// Inputs:
+//     that: The supervisor
+//   worker: The index of the worker
+// Output:
+//   Return the number of restarts
+uint64_t TryCatchSupervisorGetNbRestart(
+  struct TryCatchSupervisor* const that,
+                        int const worker) {
+
+  return atomic_load(&(that->workers[worker].nbRestart));
+
+}
+
+// ------------------ trycatchcsupervisor.c ------------------
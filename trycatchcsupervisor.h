@@ -0,0 +1,105 @@
+// ------------------ trycatchcsupervisor.h ------------------
+
+// Guard against multiple inclusions
+#ifndef TryCATCHCSUPERVISOR_H
+#define TryCATCHCSUPERVISOR_H
+
+// Include external modules header
+#include <stdlib.h>
+#include <stdint.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Supervisor keeping a pool of worker threads running. The function of
+// each worker runs in a root TryCatch block: a worker whose function
+// raises an exception it doesn't catch notifies the supervisor through a
+// lock-free queue, and is restarted according to the strategy of the
+// supervisor. A worker is restarted in its own thread, which keeps its
+// stack and its TryCatch context. If the workers are restarted more than
+// maxRestart times within period seconds, the supervisor gives up and
+// stops all the workers. A worker whose function returns normally is not
+// restarted. The workers are stopped by cancellation of their context
+// (cf. TryCatchCancel), hence their functions must call
+// TryCatchCheckpoint() at their safe points. A segmentation fault in a
+// worker is restarted as any other exception if
+// TryCatchInitHandlerSigSegv() has been called.
+struct TryCatchSupervisor;
+
+// Strategies of restart
+enum TryCatchSupervisorStrategy {
+
+  // Only the failed worker is restarted
+  TryCatchSupervisorStrategy_OneForOne,
+
+  // All the workers are restarted, the other ones are cancelled and the
+  // workers are restarted once they have all stopped
+  TryCatchSupervisorStrategy_OneForAll
+
+};
+
+// Function run by a worker
+// Input:
+//   arg: The argument of the worker
+typedef void (*TryCatchSupervisorFun)(
+  void* arg);
+
+// Function to create a supervisor and start the threads of its workers,
+// their functions are run by TryCatchSupervisorRun
+// Inputs:
+//     nbWorker: The number of workers
+//         funs: The functions of the workers
+//         args: The arguments of the workers (can be NULL if all are NULL)
+//     strategy: The strategy of restart
+//   maxRestart: The max number of restarts within period
+//       period: The period of the restart intensity, in seconds
+// Output:
+//   Return the supervisor, or NULL if it couldn't be created
+struct TryCatchSupervisor* TryCatchSupervisorCreate(
+                             int const nbWorker,
+        TryCatchSupervisorFun const* const funs,
+                     void* const* const args,
+  enum TryCatchSupervisorStrategy const strategy,
+                             int const maxRestart,
+                          double const period);
+
+// Function to free a supervisor, once TryCatchSupervisorRun has returned,
+// ending the threads of its workers
+// Input:
+//   that: The supervisor, set to NULL on return
+void TryCatchSupervisorFree(
+  struct TryCatchSupervisor** const that);
+
+// Function to run the workers of a supervisor and restart them when they
+// fail, until they have all returned or have been stopped. To be called
+// by one thread only, the supervising thread.
+// Input:
+//   that: The supervisor
+// Output:
+//   Return true if all the workers have returned normally, false if the
+//   supervisor has given up or has been stopped
+bool TryCatchSupervisorRun(
+  struct TryCatchSupervisor* const that);
+
+// Function to stop the workers of a supervisor, can be called from any
+// thread including the workers. The workers are cancelled and
+// TryCatchSupervisorRun returns once they have all stopped.
+// Input:
+//   that: The supervisor
+void TryCatchSupervisorStop(
+  struct TryCatchSupervisor* const that);
+
+// Function to get the number of restarts of a worker
+// Inputs:
+//     that: The supervisor
+//   worker: The index of the worker
+// Output:
+//   Return the number of restarts
+uint64_t TryCatchSupervisorGetNbRestart(
+  struct TryCatchSupervisor* const that,
+                        int const worker);
+
+// End of the guard against multiple inclusion
+#endif
+
+// ------------------ trycatchcsupervisor.h ------------------
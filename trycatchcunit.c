@@ -0,0 +1,567 @@
+// ------------------ trycatchcunit.c ------------------
+
+// The runner relies on POSIX threads, signals and clocks which are not
+// defined in ANSI C, request their declaration
+#define _GNU_SOURCE
+
+// Include the header
+#include "trycatchcunit.h"
+
+// Include external modules header
+#include <stdatomic.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+
+// Signal used by the watchdog to interrupt a test running longer than the
+// timeout, can be redefined at compilation if the application already
+// uses SIGUSR1
+#ifndef TryCatchTestTimeoutSignal
+#define TryCatchTestTimeoutSignal SIGUSR1
+#endif
+
+// Period in nanoseconds of the checks of the watchdog
+#define TryCatchTestWatchdogPeriod 10000000
+
+// Registered tests, in order of registration
+static struct TryCatchTestCase* testHead = NULL;
+static struct TryCatchTestCase* testTail = NULL;
+static int nbTest = 0;
+
+// Result of a test
+struct TryCatchTestResult {
+
+  // Exception raised by the test, 0 if it passed
+  int exc;
+
+  // Site of the exception (NULL if unknown)
+  struct TryCatchSite const* site;
+
+  // Wall time of the test in seconds
+  double time;
+
+};
+
+// Worker thread of the runner
+struct TryCatchTestWorker {
+
+  // Thread of the worker
+  pthread_t thread;
+
+  // Deadline of the running test in nanoseconds on the monotonic clock, 0
+  // if no test is running or there is no timeout
+  _Atomic uint64_t deadline;
+
+  // Flag to memorise if the thread of the worker has been started
+  bool isStarted;
+
+  // Flag to memorise if the worker has ended
+  _Atomic bool isDone;
+
+};
+
+// State of a run shared by the workers
+struct TryCatchTestState {
+
+  // Tests in order of registration, and their results
+  struct TryCatchTestCase** tests;
+  struct TryCatchTestResult* results;
+
+  // Index of the next test to run
+  _Atomic int next;
+
+  // Timeout of the tests in nanoseconds, 0 for no timeout
+  uint64_t timeout;
+
+};
+
+// Worker of the current thread, NULL if it's not a worker
+static _Thread_local struct TryCatchTestWorker* curWorker = NULL;
+
+// Flag to memorise if the current thread is running a test inside its
+// TryCatch block, signals received outside of it are not converted to
+// exceptions
+static _Thread_local volatile sig_atomic_t isRunningTest = 0;
+
+// Flag to memorise if the exception ending the current test has been
+// raised by a handler of the runner, in which case the site of the raise
+// is the handler and not the faulty code of the test
+static _Thread_local volatile sig_atomic_t isRaisedBySignal = 0;
+
+// Actions of the signals before the run, restored after the run
+static struct sigaction prevSigSegv;
+static struct sigaction prevSigBus;
+static struct sigaction prevSigTimeout;
+
+// Function to get the current time on the monotonic clock
+// Output:
+//   Return the time in nanoseconds
+static uint64_t TryCatchTestNow(
+  void) {
+
+  struct timespec ts;
+  clock_gettime(
+    CLOCK_MONOTONIC,
+    &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+}
+
+// Handler for SIGSEGV and SIGBUS during the run, raise TryCatchExc_Segv if
+// the signal occurs in a test, else restore the previous action and
+// return to let the fault occur again with it. The exception is raised
+// with TryCatchRaiseFromSignal, the interrupted code may be printing or
+// tracing another raise.
+// Input:
+//   signum: The received signal
+static void TryCatchTestSigFaultHandler(
+  int signum) {
+
+  if (isRunningTest) {
+
+    isRaisedBySignal = 1;
+    TryCatchRaiseFromSignal(TryCatchExc_Segv);
+
+  }
+
+  sigaction(
+    signum,
+    (signum == SIGSEGV ? &prevSigSegv : &prevSigBus),
+    NULL);
+
+}
+
+// Handler for the signal of the watchdog, raise TryCatchExc_InfiniteLoop
+// if the current test has exceeded its deadline (with
+// TryCatchRaiseFromSignal, as for the faults). The watchdog may send the
+// signal again until the test has ended.
+// Input:
+//   signum: The received signal
+static void TryCatchTestSigTimeoutHandler(
+  int signum) {
+
+  (void)signum;
+  if (isRunningTest == 0 || curWorker == NULL) return;
+  uint64_t deadline = atomic_load(&(curWorker->deadline));
+  if (deadline != 0 && TryCatchTestNow() >= deadline) {
+
+    isRaisedBySignal = 1;
+    TryCatchRaiseFromSignal(TryCatchExc_InfiniteLoop);
+
+  }
+
+}
+
+// Function to register a unit test, called automatically for the tests
+// defined with TryCatchTest
+// Input:
+//   test: The test
+void TryCatchTestRegister(
+  struct TryCatchTestCase* const test) {
+
+  test->next = NULL;
+  if (testTail != NULL) testTail->next = test;
+  else testHead = test;
+  testTail = test;
+  ++nbTest;
+
+}
+
+// Function to run one test in its own TryCatch block
+// Inputs:
+//    state: The state of the run
+//   worker: The worker running the test
+//    iTest: The index of the test
+static void TryCatchTestRunOne(
+  struct TryCatchTestState* const state,
+  struct TryCatchTestWorker* const worker,
+                         int const iTest) {
+
+  struct TryCatchTestResult* result = state->results + iTest;
+  uint64_t start = TryCatchTestNow();
+  if (state->timeout != 0)
+    atomic_store(
+      &(worker->deadline),
+      start + state->timeout);
+  Try {
+
+    isRunningTest = 1;
+    state->tests[iTest]->fun();
+    isRunningTest = 0;
+
+  } CatchDefault {
+
+    isRunningTest = 0;
+    result->exc = TryCatchGetLastExc();
+    result->site = (isRaisedBySignal ? NULL : TryCatchGetLastSite());
+    isRaisedBySignal = 0;
+
+  } EndCatch;
+  atomic_store(
+    &(worker->deadline),
+    0);
+  result->time = (double)(TryCatchTestNow() - start) * 1e-9;
+
+}
+
+// Argument of the main function of a worker thread
+struct TryCatchTestWorkerArg {
+
+  // State of the run
+  struct TryCatchTestState* state;
+
+  // Worker
+  struct TryCatchTestWorker* worker;
+
+};
+
+// Main function of a worker thread, run tests until there is no more
+// Input:
+//   arg: The state of the run and the worker
+// Output:
+//   Return NULL
+static void* TryCatchTestWorkerMain(
+  void* arg) {
+
+  struct TryCatchTestState* state =
+    ((struct TryCatchTestWorkerArg*)arg)->state;
+  struct TryCatchTestWorker* worker =
+    ((struct TryCatchTestWorkerArg*)arg)->worker;
+  curWorker = worker;
+  for (
+    int iTest = atomic_fetch_add(&(state->next), 1);
+    iTest < nbTest;
+    iTest = atomic_fetch_add(&(state->next), 1)) {
+
+    TryCatchTestRunOne(
+      state,
+      worker,
+      iTest);
+
+  }
+
+  curWorker = NULL;
+  atomic_store(
+    &(worker->isDone),
+    true);
+  return NULL;
+
+}
+
+// Function to set the handlers of the signals used during the run
+// Output:
+//   Return true if the handlers could be set, else false
+static bool TryCatchTestSetHandlers(
+  void) {
+
+  // SA_NODEFER: the handlers leave with longjmp, the signals must not
+  // stay blocked afterward for the next tests to be interrupted too
+  struct sigaction sigAction;
+  memset(
+    &sigAction,
+    0,
+    sizeof(struct sigaction));
+  sigemptyset(&(sigAction.sa_mask));
+  sigAction.sa_flags = SA_NODEFER;
+  sigAction.sa_handler = TryCatchTestSigFaultHandler;
+  if (
+    sigaction(SIGSEGV, &sigAction, &prevSigSegv) != 0 ||
+    sigaction(SIGBUS, &sigAction, &prevSigBus) != 0) {
+
+    return false;
+
+  }
+
+  sigAction.sa_handler = TryCatchTestSigTimeoutHandler;
+  return
+    sigaction(
+      TryCatchTestTimeoutSignal,
+      &sigAction,
+      &prevSigTimeout) == 0;
+
+}
+
+// Function to write a string in JSON format
+// Inputs:
+//   stream: The stream
+//      str: The string (can be NULL)
+static void TryCatchTestJsonStr(
+        FILE* const stream,
+  char const* const str) {
+
+  if (str == NULL) {
+
+    fprintf(
+      stream,
+      "null");
+    return;
+
+  }
+
+  fputc('"', stream);
+  for (
+    char const* ptr = str;
+    *ptr != '\0';
+    ++ptr) {
+
+    if (*ptr == '"' || *ptr == '\\') fputc('\\', stream);
+    if ((unsigned char)*ptr < 0x20) fprintf(stream, "\\u%04x", *ptr);
+    else fputc(*ptr, stream);
+
+  }
+
+  fputc('"', stream);
+
+}
+
+// Function to print the results of the run
+// Inputs:
+//   state: The state of the run
+//    json: The stream where to write the results in JSON format (can
+//          be NULL)
+// Output:
+//   Return the number of failed tests
+static int TryCatchTestReport(
+  struct TryCatchTestState const* const state,
+                          FILE* const json) {
+
+  int nbFail = 0;
+  if (json != NULL) fprintf(json, "{\"tests\":[");
+  for (
+    int iTest = 0;
+    iTest < nbTest;
+    ++iTest) {
+
+    struct TryCatchTestCase const* test = state->tests[iTest];
+    struct TryCatchTestResult const* result = state->results + iTest;
+    if (result->exc != 0) ++nbFail;
+
+    // Print the result in text format
+    printf(
+      "[%s] %s (%.3fs)",
+      (result->exc == 0 ? "PASS" : "FAIL"),
+      test->name,
+      result->time);
+    if (result->exc != 0) {
+
+      printf(
+        ": exception (%s)",
+        TryCatchExcToStr(result->exc));
+      if (result->site != NULL)
+        printf(
+          " raised in %s, line %d",
+          result->site->filename,
+          result->site->line);
+      else
+        printf(
+          " in test defined in %s, line %d",
+          test->filename,
+          test->line);
+      printf(".");
+
+    }
+
+    printf("\n");
+
+    // Print the result in JSON format
+    if (json != NULL) {
+
+      fprintf(json, "%s{\"name\":", (iTest > 0 ? "," : ""));
+      TryCatchTestJsonStr(json, test->name);
+      fprintf(json, ",\"file\":");
+      TryCatchTestJsonStr(json, test->filename);
+      fprintf(
+        json,
+        ",\"line\":%d,\"pass\":%s,\"time\":%.6f,\"exc\":%d,\"excName\":",
+        test->line,
+        (result->exc == 0 ? "true" : "false"),
+        result->time,
+        result->exc);
+      TryCatchTestJsonStr(
+        json,
+        (result->exc == 0 ? NULL : TryCatchExcToStr(result->exc)));
+      fprintf(json, ",\"raisedIn\":");
+      TryCatchTestJsonStr(
+        json,
+        (result->site == NULL ? NULL : result->site->filename));
+      fprintf(
+        json,
+        ",\"raisedLine\":%d}",
+        (result->site == NULL ? 0 : result->site->line));
+
+    }
+
+  }
+
+  printf(
+    "%d test(s), %d failed\n",
+    nbTest,
+    nbFail);
+  if (json != NULL)
+    fprintf(
+      json,
+      "],\"nbTest\":%d,\"nbFail\":%d}\n",
+      nbTest,
+      nbFail);
+  return nbFail;
+
+}
+
+// Function to run the registered unit tests in parallel and print their
+// result on the standard output
+// Inputs:
+//   nbThread: The number of threads running the tests
+//    timeout: The maximum duration of one test in seconds, 0 for no limit
+//       json: The stream where to write the results in JSON format (can
+//             be NULL)
+// Output:
+//   Return the number of failed tests
+int TryCatchTestRun(
+     int const nbThread,
+  double const timeout,
+   FILE* const json) {
+
+  // Allocate memory for the state of the run and the workers. If
+  // something goes wrong, all the tests are considered failed.
+  int nbWorker = (nbThread > 0 ? nbThread : 1);
+  if (nbWorker > nbTest) nbWorker = (nbTest > 0 ? nbTest : 1);
+  struct TryCatchTestState state = {
+    .tests = malloc(sizeof(struct TryCatchTestCase*) * (size_t)(nbTest + 1)),
+    .results = calloc((size_t)(nbTest + 1), sizeof(struct TryCatchTestResult)),
+    .next = 0,
+    .timeout = (timeout > 0. ? (uint64_t)(timeout * 1e9) : 0)
+  };
+  struct TryCatchTestWorker* workers =
+    calloc(
+      (size_t)nbWorker,
+      sizeof(struct TryCatchTestWorker));
+  struct TryCatchTestWorkerArg* args =
+    calloc(
+      (size_t)nbWorker,
+      sizeof(struct TryCatchTestWorkerArg));
+  if (
+    state.tests == NULL ||
+    state.results == NULL ||
+    workers == NULL ||
+    args == NULL ||
+    TryCatchTestSetHandlers() == false) {
+
+    free(state.tests);
+    free(state.results);
+    free(workers);
+    free(args);
+    return nbTest;
+
+  }
+
+  int iTest = 0;
+  for (
+    struct TryCatchTestCase* test = testHead;
+    test != NULL;
+    test = test->next) {
+
+    state.tests[iTest] = test;
+    ++iTest;
+
+  }
+
+  // Start the workers, the tests of a worker which couldn't be started are
+  // run by the others
+  int nbStarted = 0;
+  for (
+    int iWorker = 0;
+    iWorker < nbWorker;
+    ++iWorker) {
+
+    args[iWorker].state = &state;
+    args[iWorker].worker = workers + iWorker;
+    if (
+      pthread_create(
+        &(workers[iWorker].thread),
+        NULL,
+        TryCatchTestWorkerMain,
+        args + iWorker) == 0) {
+
+      workers[iWorker].isStarted = true;
+      ++nbStarted;
+
+    } else {
+
+      atomic_store(
+        &(workers[iWorker].isDone),
+        true);
+
+    }
+
+  }
+
+  // If no worker could be started, run the tests in the current thread,
+  // without timeout as there is no watchdog
+  if (nbStarted == 0) {
+
+    state.timeout = 0;
+    TryCatchTestWorkerMain(args);
+
+  }
+
+  // Watch the workers until they have all ended, and interrupt the ones
+  // whose test has exceeded the deadline
+  bool isDone = false;
+  while (isDone == false) {
+
+    isDone = true;
+    uint64_t now = TryCatchTestNow();
+    for (
+      int iWorker = 0;
+      iWorker < nbWorker;
+      ++iWorker) {
+
+      if (atomic_load(&(workers[iWorker].isDone))) continue;
+      isDone = false;
+      uint64_t deadline = atomic_load(&(workers[iWorker].deadline));
+      if (deadline != 0 && now >= deadline)
+        pthread_kill(
+          workers[iWorker].thread,
+          TryCatchTestTimeoutSignal);
+
+    }
+
+    if (isDone == false)
+      nanosleep(
+        &(struct timespec){.tv_sec = 0, .tv_nsec = TryCatchTestWatchdogPeriod},
+        NULL);
+
+  }
+
+  // Wait for the workers and restore the signal actions
+  for (
+    int iWorker = 0;
+    iWorker < nbWorker;
+    ++iWorker) {
+
+    if (workers[iWorker].isStarted)
+      pthread_join(
+        workers[iWorker].thread,
+        NULL);
+
+  }
+
+  sigaction(SIGSEGV, &prevSigSegv, NULL);
+  sigaction(SIGBUS, &prevSigBus, NULL);
+  sigaction(TryCatchTestTimeoutSignal, &prevSigTimeout, NULL);
+
+  // Print the results
+  int nbFail =
+    TryCatchTestReport(
+      &state,
+      json);
+  free(state.tests);
+  free(state.results);
+  free(workers);
+  free(args);
+  return nbFail;
+
+}
+
+// ------------------ trycatchcunit.c ------------------
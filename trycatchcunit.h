@@ -0,0 +1,85 @@
+// ------------------ trycatchcunit.h ------------------
+
+// Guard against multiple inclusions
+#ifndef TryCATCHCUNIT_H
+#define TryCATCHCUNIT_H
+
+// Include external modules header
+#include <stdlib.h>
+#include <stdio.h>
+
+// Include TryCatchC module header
+#include "trycatchc.h"
+
+// Unit tests run in parallel by a pool of threads, each test in its own
+// TryCatch block. A test fails if it raises an exception, segmentation
+// faults are converted to TryCatchExc_Segv and tests running longer than
+// the timeout are interrupted with TryCatchExc_InfiniteLoop. The runner
+// relies on POSIX threads and signals and is not available in ANSI C.
+
+// Unit test, registered with the TryCatchTest macro
+struct TryCatchTestCase {
+
+  // Name of the test
+  char const* name;
+
+  // Function of the test
+  void (*fun)(void);
+
+  // File and line of the test
+  char const* filename;
+  int line;
+
+  // Next registered test
+  struct TryCatchTestCase* next;
+
+};
+
+// Function to register a unit test, called automatically for the tests
+// defined with TryCatchTest
+// Input:
+//   test: The test
+void TryCatchTestRegister(
+  struct TryCatchTestCase* const test);
+
+// Macro to define and register a unit test, to be used at file scope as
+//
+// TryCatchTest(myTest) {
+//   /*... code of the test, using TryCatchTestAssert ...*/
+// }
+//
+// The test is registered before main is called.
+#define TryCatchTest(name)                                         \
+  static void TryCatchTestFun_##name(void);                        \
+  static struct TryCatchTestCase TryCatchTestCase_##name = {       \
+    #name, TryCatchTestFun_##name, __FILE__, __LINE__, NULL};      \
+  __attribute__((constructor)) static void TryCatchTestReg_##name( \
+    void) {                                                        \
+    TryCatchTestRegister(&TryCatchTestCase_##name);                \
+  }                                                                \
+  static void TryCatchTestFun_##name(void)
+
+// Macro to raise TryCatchExc_UnitTestFailed if a condition is false
+#define TryCatchTestAssert(cond)                    \
+  do {                                              \
+    if (!(cond)) Raise(TryCatchExc_UnitTestFailed); \
+  } while (false)
+
+// Function to run the registered unit tests in parallel and print their
+// result on the standard output
+// Inputs:
+//   nbThread: The number of threads running the tests
+//    timeout: The maximum duration of one test in seconds, 0 for no limit
+//       json: The stream where to write the results in JSON format (can
+//             be NULL)
+// Output:
+//   Return the number of failed tests
+int TryCatchTestRun(
+     int const nbThread,
+  double const timeout,
+   FILE* const json);
+
+// End of the guard against multiple inclusion
+#endif
+
+// ------------------ trycatchcunit.h ------------------